@@ -8,39 +8,206 @@
 #define VLK_ALLOC_CHUNK_HPP
 
 #include "ValkyrieEngine/ValkyrieDefs.hpp"
+#include "ValkyrieEngine/ChunkAllocator.hpp"
+#include "ValkyrieEngine/Util.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
-#include <bitset>
+#include <new>
+#include <type_traits>
 
 namespace vlk
 {
+	/*!
+	 * \brief A contiguous view of every allocation space in an AllocChunk, along with its occupation bits.
+	 *
+	 * Allocation spaces are laid out contiguously starting at <tt>data</tt>.
+	 * Space <tt>i</tt> is occupied if bit <tt>i % 64</tt> of <tt>occupations[i / 64]</tt> is set.
+	 * Unoccupied spaces do not contain initialized objects and must not be dereferenced,
+	 * but may be read as raw memory, for example by vector instructions whose results are masked out afterwards.
+	 *
+	 * \tparam T The type of object stored in the chunk. May be const-qualified.
+	 *
+	 * \sa AllocChunk<T, S>::Span()
+	 */
+	template <typename T>
+	struct ChunkSpan
+	{
+		//! Pointer to the first allocation space.
+		T* data;
+
+		//! Total number of allocation spaces, occupied or not.
+		Size size;
+
+		//! Occupation bits, one per allocation space.
+		const ULong* occupations;
+
+		//! Number of words in #occupations.
+		Size wordCount;
+
+		//! Returns true if the allocation space at position <tt>i</tt> is occupied.
+		inline bool IsOccupied(Size i) const
+		{
+			return (occupations[i / 64] >> (i % 64)) & 1;
+		}
+
+		//! Returns true if every allocation space is occupied.
+		inline bool Full() const
+		{
+			for (Size w = 0; w + 1 < wordCount; w++)
+			{
+				if (occupations[w] != ~ULong(0)) return false;
+			}
+
+			Size tail = size % 64;
+			return occupations[wordCount - 1] == (tail == 0 ? ~ULong(0) : (ULong(1) << tail) - 1);
+		}
+	};
+
+	/*!
+	 * \brief Default column type for AllocChunk, stores nothing.
+	 */
+	struct NoChunkColumns {};
+
 	/*!
 	 * \brief Fixed-capacity, variable-size storage block. Used internally by Component<T>.
 	 *
 	 * This class does not construct or destruct any instances of T, it only allocates space
 	 * for them. You must handle construction and destruction of instances yourself.
 	 *
+	 * Chunks created with Create() are aligned to Alignment() bytes, which allows the chunk
+	 * owning any of its allocation spaces to be found with FromPointer(const T*).
+	 *
 	 * \tparam T The type this Chunk is storing.
 	 * \tparam S The number of instances this chunk can allocate at once.
+	 * \tparam C Additional storage kept alongside the allocation spaces, such as arrays holding data for each space.
+	 * Constructed and destroyed along with the chunk, and accessible with Columns().
+	 * \tparam A The backing allocator Create() takes memory for chunks from, such as HeapChunkAllocator or MappedChunkAllocator.
 	 */
-	template <typename T, Size S>
+	template <typename T, Size S, typename C = NoChunkColumns, typename A = HeapChunkAllocator>
 	class AllocChunk
 	{
 		public:
 		static VLK_CXX14_CONSTEXPR Size ChunkSize = S;
-		typedef AllocChunk<T, S> SelfType;
+		typedef AllocChunk<T, S, C, A> SelfType;
 		typedef T ValueType;
 		typedef T* PointerType;
+		typedef C ColumnsType;
+		typedef A AllocatorType;
 
 		VLK_STATIC_ASSERT_MSG(ChunkSize > 0, "Component block size must be greater than zero");
 
 		private:
-		std::bitset<ChunkSize> occupations;
-		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[S];
+		// Occupation bits are packed into words so free slots can be found with a bit scan
+		static VLK_CXX14_CONSTEXPR Size WordBits = sizeof(ULong) * 8;
+		static VLK_CXX14_CONSTEXPR Size WordCount = (S + WordBits - 1) / WordBits;
+
+		// A second level of bits tracks which occupation words are completely full
+		static VLK_CXX14_CONSTEXPR Size SummaryCount = (WordCount + WordBits - 1) / WordBits;
+
+		// Mask of the bits in the final word of an array of n bits that are in use
+		static VLK_CXX14_CONSTEXPR ULong TailMask(Size n)
+		{
+			return (n % WordBits == 0) ? ~ULong(0) : ((ULong(1) << (n % WordBits)) - 1);
+		}
+
+		ULong occupations[WordCount] = {};
+		ULong fullWords[SummaryCount] = {};
+		Size ownerIndex = 0;
+
+		// Start the allocation spaces on a cache line so a chunk touches as few lines as possible
+		alignas(64) typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[S];
+		C columns;
+
+		// Mask of the bits in use for occupation word w
+		static inline ULong WordMask(Size w)
+		{
+			return (w == WordCount - 1) ? TailMask(S) : ~ULong(0);
+		}
+
+		// Mask of the bits in use for summary word w
+		static inline ULong SummaryMask(Size w)
+		{
+			return (w == SummaryCount - 1) ? TailMask(WordCount) : ~ULong(0);
+		}
 
 		public:
-		AllocChunk<T, S>() = default;
-		AllocChunk<T, S>(const SelfType&) = delete;
-		AllocChunk<T, S>(SelfType&& a) = delete;
+		/*!
+		 * \brief Forward iterator over the indices of a chunk's occupied allocation spaces.
+		 *
+		 * Occupied spaces are found by scanning occupation bits a word at a time,
+		 * so unoccupied spaces cost next to nothing to skip.
+		 *
+		 * \sa Occupied()
+		 */
+		class OccupiedIterator
+		{
+			const ULong* words;
+			Size w;
+			ULong bits;
+
+			// Moves to the next word with an occupied space, or to the end
+			inline void Advance()
+			{
+				while ((bits == 0) & (w < WordCount))
+				{
+					if (++w < WordCount) bits = words[w];
+				}
+			}
+
+			public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef Size value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const Size* pointer;
+			typedef Size reference;
+
+			OccupiedIterator(const ULong* _words, Size _w) :
+				words(_words),
+				w(_w),
+				bits(_w < WordCount ? _words[_w] : 0)
+			{
+				Advance();
+			}
+
+			inline Size operator*() const { return w * WordBits + CountTrailingZeros(bits); }
+
+			inline OccupiedIterator& operator++()
+			{
+				bits &= bits - 1;
+				Advance();
+				return *this;
+			}
+
+			inline OccupiedIterator operator++(int)
+			{
+				OccupiedIterator prev = *this;
+				++(*this);
+				return prev;
+			}
+
+			inline bool operator==(const OccupiedIterator& o) const { return (w == o.w) & (bits == o.bits); }
+			inline bool operator!=(const OccupiedIterator& o) const { return !(*this == o); }
+		};
+
+		/*!
+		 * \brief Range of the indices of a chunk's occupied allocation spaces, in ascending order.
+		 *
+		 * \sa Occupied()
+		 */
+		struct OccupiedRange
+		{
+			OccupiedIterator first;
+			OccupiedIterator last;
+
+			inline OccupiedIterator begin() const { return first; }
+			inline OccupiedIterator end() const { return last; }
+		};
+
+		AllocChunk() = default;
+		AllocChunk(const SelfType&) = delete;
+		AllocChunk(SelfType&& a) = delete;
 		SelfType& operator=(const SelfType&) = delete;
 		SelfType& operator=(SelfType&& a) = delete;
 
@@ -58,6 +225,126 @@ namespace vlk
 			}*/
 		}
 
+		/*!
+		 * \brief Returns the alignment of chunks created with Create().
+		 *
+		 * This is the size of an AllocChunk rounded up to the nearest power of two,
+		 * so that every allocation space shares the high bits of its chunk's address.
+		 */
+		static VLK_CXX14_CONSTEXPR Size Alignment()
+		{
+			return NextPowerOfTwo(sizeof(SelfType));
+		}
+
+		/*!
+		 * \brief Allocates and constructs an AllocChunk aligned to Alignment() bytes.
+		 *
+		 * Memory for the chunk is taken from the backing allocator <tt>A</tt>.
+		 * Chunks created with this function must be destroyed with Destroy(SelfType*).
+		 *
+		 * \throws std::bad_alloc If memory for the chunk could not be allocated.
+		 *
+		 * \sa Destroy(SelfType*)
+		 * \sa FromPointer(const T*)
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		VLK_NODISCARD static SelfType* Create()
+		{
+			void* p = A::Allocate(Alignment(), sizeof(SelfType));
+			if (p == nullptr) throw std::bad_alloc();
+			return new (p) SelfType();
+		}
+
+		/*!
+		 * \brief Destroys and frees a chunk created with Create().
+		 *
+		 * \sa Create()
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Unique access to <tt>chunk</tt> is required.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static void Destroy(SelfType* chunk)
+		{
+			chunk->~SelfType();
+			A::Deallocate(chunk, sizeof(SelfType));
+		}
+
+		/*!
+		 * \brief Returns the chunk that owns the allocation space <tt>t</tt>.
+		 *
+		 * The owning chunk is found by masking the address of <tt>t</tt>, so this is only valid
+		 * for allocation spaces belonging to chunks created with Create().
+		 *
+		 * \sa IndexOf(const T*)
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Access to this object is not restricted.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static inline SelfType* FromPointer(const T* t)
+		{
+			return reinterpret_cast<SelfType*>(reinterpret_cast<std::uintptr_t>(t) & ~static_cast<std::uintptr_t>(Alignment() - 1));
+		}
+
+		/*!
+		 * \brief Returns the position of the allocation space <tt>t</tt> within this chunk.
+		 *
+		 * \param t A pointer to an allocation space that this chunk owns.
+		 *
+		 * \sa OwnsPointer(T*)
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Access to this object is not restricted.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		inline Size IndexOf(const T* t) const
+		{
+			return static_cast<Size>(t - At(0));
+		}
+
+		/*!
+		 * \brief Returns the position of this chunk within its owner's list of chunks.
+		 *
+		 * This value is not used by AllocChunk itself, it lets a container locate a chunk
+		 * retrieved with FromPointer(const T*) without searching for it.
+		 *
+		 * \sa SetOwnerIndex(Size)
+		 */
+		inline Size GetOwnerIndex() const { return ownerIndex; }
+
+		/*!
+		 * \brief Sets the value returned by GetOwnerIndex().
+		 *
+		 * \sa GetOwnerIndex()
+		 */
+		inline void SetOwnerIndex(Size i) { ownerIndex = i; }
+
+		/*!
+		 * \brief Returns the additional storage kept alongside this chunk's allocation spaces.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Access to this object is not restricted.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		inline C& Columns() { return columns; }
+
+		/*!
+		 * \copydoc Columns()
+		 */
+		inline const C& Columns() const { return columns; }
+
 		/*!
 		 * \brief Returns true if none of this chunk's allocation spaces are filled.
 		 *
@@ -67,7 +354,15 @@ namespace vlk
 		 * Access to this object is not restricted.<br>
 		 * This function does not block the calling thread.<br>
 		 */
-		inline bool Empty() const { return occupations.none(); }
+		inline bool Empty() const
+		{
+			for (Size w = 0; w < WordCount; w++)
+			{
+				if (occupations[w] != 0) return false;
+			}
+
+			return true;
+		}
 
 		/*!
 		 * \brief Returns true if all of this chunk's allocation spaces are filled.
@@ -78,7 +373,15 @@ namespace vlk
 		 * Access to this object is not restricted.<br>
 		 * This function does not block the calling thread.<br>
 		 */
-		inline bool Full() const { return occupations.all(); }
+		inline bool Full() const
+		{
+			for (Size w = 0; w < SummaryCount; w++)
+			{
+				if (fullWords[w] != SummaryMask(w)) return false;
+			}
+
+			return true;
+		}
 
 		/*!
 		 * \brief Returns true if the allocation space at position <tt>i</tt> is occupied.
@@ -89,7 +392,95 @@ namespace vlk
 		 * Access to this object is not restricted.<br>
 		 * This function does not block the calling thread.<br>
 		 */
-		inline bool IsOccupied(Size i) const { return occupations[i]; }
+		inline bool IsOccupied(Size i) const
+		{
+			return (occupations[i / WordBits] >> (i % WordBits)) & 1;
+		}
+
+		/*!
+		 * \brief Returns a range over the indices of every occupied allocation space.
+		 *
+		 * \code{.cpp}
+		 * for (Size i : chunk.Occupied())
+		 * {
+		 *     chunk.At(i)->Foo();
+		 * }
+		 * \endcode
+		 *
+		 * \sa ForEachOccupied(F&&)
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Access to this object is not restricted.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		inline OccupiedRange Occupied() const
+		{
+			return OccupiedRange { OccupiedIterator(occupations, 0), OccupiedIterator(occupations, WordCount) };
+		}
+
+		/*!
+		 * \brief Calls <tt>func</tt> with the index of every occupied allocation space, in ascending order.
+		 *
+		 * Words of occupation bits that are completely full are visited without testing any bits,
+		 * so this is the fastest way to visit a densely occupied chunk.
+		 * <tt>func</tt> must not allocate or deallocate spaces in this chunk.
+		 *
+		 * \param func A function object that accepts a single Size.
+		 *
+		 * \sa Occupied()
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Access to this object is not restricted.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		template <typename F>
+		inline void ForEachOccupied(F&& func) const
+		{
+			for (Size w = 0; w < WordCount; w++)
+			{
+				ULong bits = occupations[w];
+				Size base = w * WordBits;
+
+				if (bits == WordMask(w))
+				{
+					Size end = (w == WordCount - 1) ? S : base + WordBits;
+					for (Size i = base; i < end; i++) func(i);
+				}
+				else
+				{
+					for (; bits != 0; bits &= bits - 1) func(base + CountTrailingZeros(bits));
+				}
+			}
+		}
+
+		/*!
+		 * \brief Returns a view of every allocation space in this chunk and its occupation bits.
+		 *
+		 * The view remains valid until this chunk is destroyed,
+		 * but its occupation bits change as spaces are allocated and deallocated.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Access to this object is not restricted.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		inline ChunkSpan<T> Span()
+		{
+			return ChunkSpan<T> { At(0), S, occupations, WordCount };
+		}
+
+		/*!
+		 * \copydoc Span()
+		 */
+		inline ChunkSpan<const T> Span() const
+		{
+			return ChunkSpan<const T> { At(0), S, occupations, WordCount };
+		}
 
 		/*!
 		 * \brief Returns a pointer to the allocation space at position <tt>i</tt>.
@@ -145,6 +536,9 @@ namespace vlk
 		 * This does not initialize an instance of <tt>T</tt>. You must construct
 		 * an instance of <tt>T</tt> at this pointer before it is safe to dereference.
 		 *
+		 * Free spaces are located by scanning occupation bits a word at a time,
+		 * so the cost of this function does not depend on how many spaces are occupied.
+		 *
 		 * \throws std::bad_alloc If the chunk is full when the function is invoked.
 		 *
 		 * \ts
@@ -155,13 +549,22 @@ namespace vlk
 		 */
 		VLK_NODISCARD T* Allocate()
 		{
-			for (Size i = 0; i < ChunkSize; i++)
+			for (Size s = 0; s < SummaryCount; s++)
 			{
-				if (!occupations[i])
+				ULong openWords = ~fullWords[s] & SummaryMask(s);
+				if (openWords == 0) continue;
+
+				Size w = s * WordBits + CountTrailingZeros(openWords);
+				Size b = CountTrailingZeros(~occupations[w] & WordMask(w));
+
+				occupations[w] |= ULong(1) << b;
+
+				if (occupations[w] == WordMask(w))
 				{
-					occupations.set(i);
-					return At(i);
+					fullWords[s] |= ULong(1) << (w % WordBits);
 				}
+
+				return At(w * WordBits + b);
 			}
 
 			throw std::bad_alloc();
@@ -186,8 +589,11 @@ namespace vlk
 		 */
 		inline void Deallocate(T* t)
 		{
-			Size s = t - At(0);
-			occupations.reset(s);
+			Size i = IndexOf(t);
+			Size w = i / WordBits;
+
+			occupations[w] &= ~(ULong(1) << (i % WordBits));
+			fullWords[w / WordBits] &= ~(ULong(1) << (w % WordBits));
 		}
 
 		/*!
@@ -201,12 +607,28 @@ namespace vlk
 		 */
 		inline Size Count() const
 		{
-			return occupations.count();
+			Size total = 0;
+
+			for (Size w = 0; w < WordCount; w++)
+			{
+				total += PopCount(occupations[w]);
+			}
+
+			return total;
 		}
 	};
 
-	template <typename T, Size S>
-	VLK_CXX14_CONSTEXPR Size AllocChunk<T, S>::ChunkSize;
+	template <typename T, Size S, typename C, typename A>
+	VLK_CXX14_CONSTEXPR Size AllocChunk<T, S, C, A>::ChunkSize;
+
+	template <typename T, Size S, typename C, typename A>
+	VLK_CXX14_CONSTEXPR Size AllocChunk<T, S, C, A>::WordBits;
+
+	template <typename T, Size S, typename C, typename A>
+	VLK_CXX14_CONSTEXPR Size AllocChunk<T, S, C, A>::WordCount;
+
+	template <typename T, Size S, typename C, typename A>
+	VLK_CXX14_CONSTEXPR Size AllocChunk<T, S, C, A>::SummaryCount;
 }
 
 #endif
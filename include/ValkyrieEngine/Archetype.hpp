@@ -0,0 +1,448 @@
+/*!
+ * \file Archetype.hpp
+ * \brief Provides archetype-based component storage, an alternative to Component<T>
+ */
+
+#ifndef VLK_ARCHETYPE_HPP
+#define VLK_ARCHETYPE_HPP
+
+#include "ValkyrieEngine/ValkyrieDefs.hpp"
+#include "ValkyrieEngine/ECS.hpp"
+#include "ValkyrieEngine/Util.hpp"
+
+#include <atomic>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vlk
+{
+	/*!
+	 * \brief Describes how to store one data type in an Archetype, without knowing the type.
+	 *
+	 * \sa ArchetypeTypeOf()
+	 */
+	struct ArchetypeTypeInfo
+	{
+		//! A number unique to the described type, assigned in the order types are first used.
+		Size id;
+
+		//! <tt>sizeof</tt> the described type.
+		Size size;
+
+		//! <tt>alignof</tt> the described type.
+		Size alignment;
+
+		//! Move-constructs an instance at <tt>dst</tt> from the instance at <tt>src</tt>, then destroys the instance at <tt>src</tt>.
+		void (*relocate)(void* dst, void* src);
+
+		//! Destroys the instance at <tt>p</tt>.
+		void (*destroy)(void* p);
+	};
+
+	/*!
+	 * \brief Returns the next unused ArchetypeTypeInfo::id.
+	 */
+	inline Size NextArchetypeTypeID()
+	{
+		static std::atomic<Size> next(0);
+		return next++;
+	}
+
+	template <typename T>
+	void RelocateArchetypeData(void* dst, void* src)
+	{
+		T* s = static_cast<T*>(src);
+		new (dst) T(std::move(*s));
+		s->~T();
+	}
+
+	template <typename T>
+	void DestroyArchetypeData(void* p)
+	{
+		static_cast<T*>(p)->~T();
+	}
+
+	/*!
+	 * \brief Returns the ArchetypeTypeInfo describing T.
+	 *
+	 * \ts
+	 * May be called from any thread.<br>
+	 * This function does not block the calling thread.<br>
+	 */
+	template <typename T>
+	const ArchetypeTypeInfo& ArchetypeTypeOf()
+	{
+		VLK_STATIC_ASSERT_MSG(std::is_move_constructible<T>::value, "Types stored in archetypes must be move-constructible.");
+		VLK_STATIC_ASSERT_MSG(alignof(T) <= 64, "Types stored in archetypes must not be over-aligned.");
+
+		static const ArchetypeTypeInfo info = { NextArchetypeTypeID(), sizeof(T), alignof(T), &RelocateArchetypeData<T>, &DestroyArchetypeData<T> };
+		return info;
+	}
+
+	/*!
+	 * \brief Storage for every entity that has exactly the same set of data types in ArchetypeStorage.
+	 *
+	 * Rows are packed densely into fixed-size chunks of ChunkBytes bytes.
+	 * Each chunk holds the entity of every row, followed by one 64-byte aligned array for each data type,
+	 * so iterating a type visits contiguous memory.
+	 * Removing a row moves the last row into its place, so row numbers are not stable.
+	 *
+	 * Archetypes are created and managed by ArchetypeStorage.
+	 *
+	 * \sa ArchetypeStorage
+	 */
+	class Archetype
+	{
+		friend class ArchetypeStorage;
+
+		std::vector<const ArchetypeTypeInfo*> types;
+		std::vector<Size> offsets;
+		std::vector<UByte*> chunks;
+		Size capacity;
+		Size count;
+
+		// Archetypes reached by adding or removing one type, keyed by ArchetypeTypeInfo::id
+		std::unordered_map<Size, Archetype*> addEdges;
+		std::unordered_map<Size, Archetype*> removeEdges;
+
+		explicit Archetype(const std::vector<const ArchetypeTypeInfo*>& types);
+
+		// Appends a row for eId without constructing any data, returns the new row.
+		Size Push(EntityID eId);
+
+		// Moves the last row into row, whose data must already have been destroyed or moved out, and removes the last row.
+		// Returns the entity that now occupies row, or the entity that was removed if row was the last row.
+		EntityID Remove(Size row);
+
+		public:
+		//! The number of bytes in each chunk.
+		static VLK_CXX14_CONSTEXPR Size ChunkBytes = 16 * 1024;
+
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype(Archetype&&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+		Archetype& operator=(Archetype&&) = delete;
+
+		//! Returns the data types stored for every entity in this archetype, ordered by ArchetypeTypeInfo::id.
+		inline const std::vector<const ArchetypeTypeInfo*>& Types() const { return types; }
+
+		//! Returns the number of entities in this archetype.
+		inline Size Count() const { return count; }
+
+		//! Returns the number of rows that fit in each chunk.
+		inline Size ChunkCapacity() const { return capacity; }
+
+		//! Returns the number of chunks in use.
+		inline Size ChunkCount() const { return (count + capacity - 1) / capacity; }
+
+		//! Returns the number of rows in use in chunk <tt>c</tt>.
+		inline Size RowsIn(Size c) const { return (c + 1 < ChunkCount()) ? capacity : count - c * capacity; }
+
+		/*!
+		 * \brief Returns the position in Types() of the type with the given ArchetypeTypeInfo::id,
+		 * or <tt>Types().size()</tt> if this archetype doesn't store it.
+		 */
+		Size ColumnOf(Size typeId) const;
+
+		//! Returns the entity of every row in chunk <tt>c</tt>.
+		inline EntityID* Entities(Size c) { return reinterpret_cast<EntityID*>(chunks[c]); }
+
+		//! Returns the array of data in column <tt>column</tt> for every row in chunk <tt>c</tt>.
+		inline void* Column(Size c, Size column) { return chunks[c] + offsets[column]; }
+
+		//! Returns the entity in row <tt>row</tt>.
+		inline EntityID EntityAt(Size row) { return Entities(row / capacity)[row % capacity]; }
+
+		//! Returns the data in column <tt>column</tt> of row <tt>row</tt>.
+		inline void* At(Size column, Size row)
+		{
+			return static_cast<UByte*>(Column(row / capacity, column)) + (row % capacity) * types[column]->size;
+		}
+	};
+
+	/*!
+	 * \brief Archetype-based storage for data attached to entities.
+	 *
+	 * This is an opt-in alternative to Component<T> for data that is mostly processed by systems touching several types at once.
+	 * Every entity with exactly the same set of types stored here shares one Archetype, which keeps each type in a dense array,
+	 * so an ArchetypeQuery visiting several types reads memory sequentially instead of jumping between unrelated pools.
+	 *
+	 * The price is that attaching or detaching a type moves all of an entity's data to a different archetype,
+	 * invalidating any pointer to it. An entity can have at most one instance of each type here.
+	 * Data stored here is independent of any Component<T> attached to the same entity, and is deleted by Entity::Delete(EntityID).
+	 *
+	 * \code{.cpp}
+	 * EntityID eId = Entity::Create();
+	 * ArchetypeStorage::Attach<Position>(eId, 0.0f, 0.0f);
+	 * ArchetypeStorage::Attach<Velocity>(eId, 1.0f, 0.0f);
+	 *
+	 * ArchetypeQuery<Position, Velocity>::ForEach([dt](Position& p, Velocity& v)
+	 * {
+	 *     p.x += v.x * dt;
+	 * });
+	 * \endcode
+	 *
+	 * \sa ArchetypeQuery
+	 */
+	class ArchetypeStorage
+	{
+		template <typename... Ts>
+		friend class ArchetypeQuery;
+
+		typedef void (*ConstructFunc)(void* dst, void* args);
+		typedef void (*VisitFunc)(Archetype& archetype, const Size* columns, void* context);
+
+		// Returns the archetype storing exactly types, which must be ordered by id, creating it if necessary.
+		static Archetype* FindArchetype(const std::vector<const ArchetypeTypeInfo*>& types);
+
+		// Returns the archetype storing the types of from plus type. from may be null.
+		static Archetype* WithType(Archetype* from, const ArchetypeTypeInfo& type);
+
+		// Returns the archetype storing the types of from except type, or null if that leaves no types.
+		static Archetype* WithoutType(Archetype* from, const ArchetypeTypeInfo& type);
+
+		static void* AttachErased(EntityID eId, const ArchetypeTypeInfo& type, ConstructFunc construct, void* args);
+		static bool DetachErased(EntityID eId, const ArchetypeTypeInfo& type);
+		static void* GetErased(EntityID eId, const ArchetypeTypeInfo& type);
+		static void VisitMatching(const ArchetypeTypeInfo* const* types, Size n, bool exclusive, VisitFunc visit, void* context);
+
+		template <typename T, typename Tuple, Size... I>
+		static void ConstructFrom(void* dst, Tuple& args, std::index_sequence<I...>)
+		{
+			new (dst) T(std::forward<typename std::tuple_element<I, Tuple>::type>(std::get<I>(args))...);
+		}
+
+		template <typename T, typename... Args>
+		static void Construct(void* dst, void* args)
+		{
+			ConstructFrom<T>(dst, *static_cast<std::tuple<Args&&...>*>(args), std::index_sequence_for<Args...>());
+		}
+
+		public:
+		/*!
+		 * \brief Constructs an instance of T and attaches it to an entity.
+		 *
+		 * The entity is moved to the archetype of its current types plus T.
+		 *
+		 * \param eId The entity to attach to.
+		 * \param args Arguments to be forwarded to the constructor of T.
+		 *
+		 * \return A pointer to the new instance, valid until the entity's set of types changes or Delete(EntityID) is called.
+		 *
+		 * \throws std::logic_error If the entity already has an instance of T in this storage.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa Detach(EntityID)
+		 */
+		template <typename T, typename... Args>
+		static T* Attach(EntityID eId, Args&&... args)
+		{
+			VLK_STATIC_ASSERT_MSG((std::is_constructible<T, Args&&...>::value), "Cannot construct an instance of T from the provided args.");
+
+			std::tuple<Args&&...> forwarded(std::forward<Args>(args)...);
+			return static_cast<T*>(AttachErased(eId, ArchetypeTypeOf<T>(), &Construct<T, Args...>, &forwarded));
+		}
+
+		/*!
+		 * \brief Destroys an entity's instance of T.
+		 *
+		 * The entity is moved to the archetype of its remaining types.
+		 *
+		 * \return True if the entity had an instance of T.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa Attach(EntityID, Args&&...)
+		 */
+		template <typename T>
+		static bool Detach(EntityID eId)
+		{
+			return DetachErased(eId, ArchetypeTypeOf<T>());
+		}
+
+		/*!
+		 * \brief Returns an entity's instance of T, or <tt>nullptr</tt> if it has none.
+		 *
+		 * The returned pointer is valid until the entity's set of types changes or Delete(EntityID) is called.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		template <typename T>
+		VLK_NODISCARD static T* Get(EntityID eId)
+		{
+			return static_cast<T*>(GetErased(eId, ArchetypeTypeOf<T>()));
+		}
+
+		/*!
+		 * \brief Destroys everything an entity has in this storage.
+		 *
+		 * Called by Entity::Delete(EntityID).
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void Delete(EntityID eId);
+
+		/*!
+		 * \brief Returns the number of entities that have at least one type in this storage.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static Size EntityCount();
+
+		/*!
+		 * \brief Returns the number of archetypes that have been created.
+		 *
+		 * Archetypes are kept once created, even if they become empty.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static Size ArchetypeCount();
+	};
+
+	/*!
+	 * \brief Iterates every entity in ArchetypeStorage that has an instance of each of the types <tt>Ts...</tt>.
+	 *
+	 * Only archetypes that contain every type are visited, and each is visited a chunk at a time,
+	 * so the data for each type is read from contiguous arrays.
+	 *
+	 * \tparam Ts The data types to visit, which must all be different.
+	 *
+	 * \sa ArchetypeStorage
+	 */
+	template <typename... Ts>
+	class ArchetypeQuery
+	{
+		VLK_STATIC_ASSERT_MSG(sizeof...(Ts) > 0, "A query must contain at least one type.");
+		VLK_STATIC_ASSERT_MSG(AllDistinct<Ts...>::value, "A query cannot contain the same type more than once.");
+
+		template <typename F, Size... I>
+		static void Visit(Archetype& archetype, const Size* columns, F& func, std::index_sequence<I...>)
+		{
+			for (Size c = 0; c < archetype.ChunkCount(); c++)
+			{
+				func(archetype.RowsIn(c), const_cast<const EntityID*>(archetype.Entities(c)), static_cast<Ts*>(archetype.Column(c, columns[I]))...);
+			}
+		}
+
+		template <typename F>
+		static void VisitChunks(bool exclusive, F& func)
+		{
+			const ArchetypeTypeInfo* types[] = { &ArchetypeTypeOf<Ts>()... };
+
+			ArchetypeStorage::VisitMatching(types, sizeof...(Ts), exclusive, [](Archetype& archetype, const Size* columns, void* context)
+			{
+				Visit(archetype, columns, *static_cast<F*>(context), std::index_sequence_for<Ts...>());
+			}, &func);
+		}
+
+		public:
+		/*!
+		 * \brief Performs a mutating function on every chunk of every matching archetype.
+		 *
+		 * \param func A function object that can be called with the number of rows in the chunk,
+		 * a pointer to the entity of each row, and a pointer to an array of each type in <tt>Ts...</tt>, in order.
+		 * <tt>func</tt> must not call any function of ArchetypeStorage.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to ArchetypeStorage is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * ArchetypeQuery<Position, Velocity>::ForEachChunk([dt](Size n, const EntityID*, Position* p, Velocity* v)
+		 * {
+		 *     for (Size i = 0; i < n; i++) p[i].x += v[i].x * dt;
+		 * });
+		 * \endcode
+		 *
+		 * \sa ForEach(F&&)
+		 */
+		template <typename F>
+		static void ForEachChunk(F&& func)
+		{
+			VisitChunks(true, func);
+		}
+
+		/*!
+		 * \brief Performs a mutating function on every entity with every type in <tt>Ts...</tt>.
+		 *
+		 * \param func A function object that can be called with a reference to each type in <tt>Ts...</tt>, in order.
+		 * <tt>func</tt> must not call any function of ArchetypeStorage.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to ArchetypeStorage is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa ForEachChunk(F&&)
+		 */
+		template <typename F>
+		static void ForEach(F&& func)
+		{
+			auto perRow = [&func](Size n, const EntityID*, Ts*... data)
+			{
+				for (Size i = 0; i < n; i++) func(data[i]...);
+			};
+
+			VisitChunks(true, perRow);
+		}
+
+		/*!
+		 * \brief Performs a non-mutating function on every entity with every type in <tt>Ts...</tt>.
+		 *
+		 * \param func A function object that can be called with a const reference to each type in <tt>Ts...</tt>, in order.
+		 * <tt>func</tt> must not call any function of ArchetypeStorage that requires unique access.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to ArchetypeStorage is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		template <typename F>
+		static void CForEach(F&& func)
+		{
+			auto perRow = [&func](Size n, const EntityID*, Ts*... data)
+			{
+				for (Size i = 0; i < n; i++) func(static_cast<const Ts&>(data[i])...);
+			};
+
+			VisitChunks(false, perRow);
+		}
+	};
+}
+
+#endif
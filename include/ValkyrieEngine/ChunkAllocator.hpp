@@ -0,0 +1,272 @@
+/*!
+ * \file ChunkAllocator.hpp
+ *
+ * \brief Provides the backing allocators used by AllocChunk<T, S, C, A>.
+ */
+
+#ifndef VLK_CHUNK_ALLOCATOR_HPP
+#define VLK_CHUNK_ALLOCATOR_HPP
+
+#include "ValkyrieEngine/ValkyrieDefs.hpp"
+#include "ValkyrieEngine/Util.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace vlk
+{
+	/*!
+	 * \brief Backing allocator that takes every chunk from the heap.
+	 *
+	 * This is the default allocator for AllocChunk.
+	 * A backing allocator must provide the two static functions shown here.
+	 *
+	 * \sa MappedChunkAllocator
+	 */
+	struct HeapChunkAllocator
+	{
+		/*!
+		 * \brief Allocates <tt>size</tt> bytes of uninitialized memory aligned to <tt>alignment</tt> bytes.
+		 *
+		 * \return A pointer to the allocated memory, or <tt>nullptr</tt> if the allocation failed.
+		 */
+		static inline void* Allocate(Size alignment, Size size)
+		{
+			return AlignedAlloc(alignment, size);
+		}
+
+		/*!
+		 * \brief Releases memory returned by Allocate(Size, Size).
+		 */
+		static inline void Deallocate(void* p, Size)
+		{
+			AlignedFree(p);
+		}
+	};
+
+	/*!
+	 * \brief Reserves and commits virtual memory for MappedChunkAllocator.
+	 *
+	 * Wraps <tt>mmap</tt> and <tt>mprotect</tt>, or <tt>VirtualAlloc</tt> on Windows,
+	 * so that the platform headers stay out of this header.
+	 */
+	class VirtualMemory
+	{
+		public:
+		/*!
+		 * \brief Reserves <tt>size</tt> bytes of address space without committing any memory to it.
+		 *
+		 * \return The start of the reserved address space, or <tt>nullptr</tt> if it could not be reserved.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static void* Reserve(Size size);
+
+		/*!
+		 * \brief Commits readable and writable memory to <tt>size</tt> bytes of reserved address space starting at <tt>p</tt>.
+		 *
+		 * <tt>p</tt> and <tt>size</tt> must be multiples of the page size.
+		 *
+		 * \return True if the memory was committed.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static bool Commit(void* p, Size size);
+
+		/*!
+		 * \brief Asks for <tt>size</tt> bytes of address space starting at <tt>p</tt> to be backed by huge pages.
+		 *
+		 * Does nothing on platforms without transparent huge pages.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static void AdviseHugePages(void* p, Size size);
+	};
+
+	/*!
+	 * \brief Backing allocator that places chunks side by side in a reserved region of virtual memory.
+	 *
+	 * The first allocation reserves <tt>R</tt> bytes of address space, rounded up to a multiple of 64 KiB, without committing any memory to it.
+	 * Chunks are then committed one after another from the start of the region, so chunks allocated together are adjacent in memory.
+	 * On Linux the region is marked for transparent huge pages with <tt>madvise</tt>,
+	 * which lets many chunks share a single TLB entry.
+	 *
+	 * Chunks that are deallocated stay committed and are handed out again by later allocations.
+	 * Once the region is exhausted, further chunks are allocated from the heap as if by HeapChunkAllocator.
+	 *
+	 * Chunks are aligned to their size rounded up to a power of two, as AllocChunk requires,
+	 * and the padding between one chunk and the next is committed along with them.
+	 *
+	 * Every instantiation keeps its own region, <tt>Tag</tt> exists only to tell instantiations apart.
+	 *
+	 * \tparam Tag Any type, usually the type of object stored in the chunks.
+	 * \tparam R The number of bytes of address space to reserve.
+	 *
+	 * \sa ComponentHints::allocRegionBytes
+	 */
+	template <typename Tag, Size R>
+	class MappedChunkAllocator
+	{
+		VLK_STATIC_ASSERT_MSG(R > 0, "Reserved region size must be greater than zero");
+
+		// Regions are aligned to this boundary so they can start on a huge page
+		static VLK_CXX14_CONSTEXPR Size HugePageSize = 2 * 1024 * 1024;
+
+		// Memory is committed in steps of this many bytes, a multiple of every common page size
+		static VLK_CXX14_CONSTEXPR Size CommitStep = 64 * 1024;
+
+		// The region is rounded up to a whole number of commit steps
+		static VLK_CXX14_CONSTEXPR Size RegionSize = (R + CommitStep - 1) / CommitStep * CommitStep;
+
+		static std::mutex s_mtx;
+		static std::uintptr_t s_base;
+		static std::uintptr_t s_next;
+		static std::uintptr_t s_committed;
+		static std::uintptr_t s_end;
+		static std::vector<void*> s_freeChunks;
+
+		// Reserves address space for the region, sets s_base to 0 if it could not be reserved.
+		static void Reserve(Size alignment)
+		{
+			Size boundary = (alignment > HugePageSize) ? alignment : HugePageSize;
+			Size length = RegionSize + boundary;
+
+			void* p = VirtualMemory::Reserve(length);
+			if (p == nullptr) return;
+
+			std::uintptr_t start = reinterpret_cast<std::uintptr_t>(p);
+			s_base = (start + boundary - 1) & ~static_cast<std::uintptr_t>(boundary - 1);
+			s_next = s_base;
+			s_committed = s_base;
+			s_end = s_base + RegionSize;
+
+			VirtualMemory::AdviseHugePages(reinterpret_cast<void*>(s_base), RegionSize);
+		}
+
+		// Takes memory from the end of the used part of the region, committing more if needed.
+		// Returns nullptr if it does not fit.
+		static void* Commit(Size alignment, Size size)
+		{
+			std::uintptr_t p = (s_next + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+			if ((p < s_next) | (p + size > s_end)) return nullptr;
+
+			if (p + size > s_committed)
+			{
+				std::uintptr_t last = p + size;
+				last = std::min(s_end, (last + CommitStep - 1) & ~static_cast<std::uintptr_t>(CommitStep - 1));
+				void* first = reinterpret_cast<void*>(s_committed);
+
+				if (!VirtualMemory::Commit(first, last - s_committed)) return nullptr;
+
+				s_committed = last;
+			}
+
+			s_next = p + size;
+			return reinterpret_cast<void*>(p);
+		}
+
+		public:
+		/*!
+		 * \brief Allocates <tt>size</tt> bytes of uninitialized memory aligned to <tt>alignment</tt> bytes.
+		 *
+		 * Every call must use the same <tt>alignment</tt> and <tt>size</tt>.
+		 *
+		 * \return A pointer to the allocated memory, or <tt>nullptr</tt> if the allocation failed.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void* Allocate(Size alignment, Size size)
+		{
+			std::unique_lock<std::mutex> ulock(s_mtx);
+
+			if (!s_freeChunks.empty())
+			{
+				void* p = s_freeChunks.back();
+				s_freeChunks.pop_back();
+				return p;
+			}
+
+			if (s_base == 0) Reserve(alignment);
+
+			void* p = (s_base == 0) ? nullptr : Commit(alignment, size);
+			return (p == nullptr) ? AlignedAlloc(alignment, size) : p;
+		}
+
+		/*!
+		 * \brief Releases memory returned by Allocate(Size, Size).
+		 *
+		 * Memory within the reserved region is kept for reuse rather than returned to the system.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void Deallocate(void* p, Size)
+		{
+			std::unique_lock<std::mutex> ulock(s_mtx);
+
+			if (Contains(p))
+			{
+				s_freeChunks.push_back(p);
+			}
+			else
+			{
+				AlignedFree(p);
+			}
+		}
+
+		/*!
+		 * \brief Returns true if <tt>p</tt> lies within the reserved region.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static inline bool Contains(const void* p)
+		{
+			std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+			return (a >= s_base) & (a < s_end);
+		}
+	};
+
+	template <typename Tag, Size R>
+	VLK_CXX14_CONSTEXPR Size MappedChunkAllocator<Tag, R>::HugePageSize;
+
+	template <typename Tag, Size R>
+	VLK_CXX14_CONSTEXPR Size MappedChunkAllocator<Tag, R>::CommitStep;
+
+	template <typename Tag, Size R>
+	VLK_CXX14_CONSTEXPR Size MappedChunkAllocator<Tag, R>::RegionSize;
+
+	template <typename Tag, Size R>
+	std::mutex MappedChunkAllocator<Tag, R>::s_mtx;
+
+	template <typename Tag, Size R>
+	std::uintptr_t MappedChunkAllocator<Tag, R>::s_base = 0;
+
+	template <typename Tag, Size R>
+	std::uintptr_t MappedChunkAllocator<Tag, R>::s_next = 0;
+
+	template <typename Tag, Size R>
+	std::uintptr_t MappedChunkAllocator<Tag, R>::s_committed = 0;
+
+	template <typename Tag, Size R>
+	std::uintptr_t MappedChunkAllocator<Tag, R>::s_end = 0;
+
+	template <typename Tag, Size R>
+	std::vector<void*> MappedChunkAllocator<Tag, R>::s_freeChunks;
+}
+
+#endif
@@ -7,20 +7,41 @@
 #define VLK_COMPONENT_HPP
 
 #include "ValkyrieEngine/AllocChunk.hpp"
+#include "ValkyrieEngine/ComponentFields.hpp"
 #include "ValkyrieEngine/IComponent.hpp"
 #include "ValkyrieEngine/Entity.hpp"
+#include "ValkyrieEngine/EntityIndex.hpp"
+#include "ValkyrieEngine/Signature.hpp"
+#include "ValkyrieEngine/ThreadPool.hpp"
 
 #include <stdexcept>
 #include <type_traits>
 #include <unordered_map>
+#include <algorithm>
+#include <exception>
 #include <functional>
 #include <shared_mutex>
+#include <utility>
+#include <vector>
 
 namespace vlk
 {
+	/*!
+	 * \brief Ways in which the data of a component type can be laid out in memory.
+	 *
+	 * \sa ComponentHints::layout
+	 */
+	enum class ComponentLayout
+	{
+		ArrayOfStructs,	/*!< Each component is a single object deriving from T. */
+		StructOfArrays	/*!< Each field listed by ComponentFields<T> is stored in its own array, Component<T> does not derive from T. */
+	};
+
 	/*!
 	 * \brief Hint struct used to specify some component-related behaviour.
 	 *
+	 * The number of component types a program can use is not a hint, it is set by VLK_MAX_COMPONENT_TYPES.
+	 *
 	 * \sa GetComponentHints()
 	 * \sa Component
 	 */
@@ -33,6 +54,7 @@ namespace vlk
 		 * This hint is used to specify the number of components that can fit in each storage block.
 		 *
 		 * \sa allocAutoResize
+		 * \sa allocBlockBytes
 		 */
 		const Size allocBlockSize = 64;
 
@@ -52,6 +74,104 @@ namespace vlk
 		 * \sa allocBlockSize
 		 */
 		const bool allocAutoResize = true;
+
+		/*!
+		 * \brief Number of empty allocation blocks to keep around for reuse.
+		 *
+		 * When a storage block becomes empty it is kept in reserve instead of being freed,
+		 * as long as fewer than this many blocks are already being kept.
+		 * New storage blocks are taken from this reserve before any memory is allocated,
+		 * which stops components that are repeatedly created and deleted around a block boundary
+		 * from allocating and freeing a block each time.
+		 *
+		 * Reserved blocks can be released with Component<T>::ShrinkToFit().
+		 *
+		 * \sa allocBlockSize
+		 */
+		const Size allocRetainedBlocks = 1;
+
+		/*!
+		 * \brief Number of components to reserve storage for before the first component is created.
+		 *
+		 * The first time a component of this type needs a storage block, enough blocks are allocated
+		 * to hold this many components, as if Component<T>::Reserve(Size) had been called.
+		 * Reserved blocks are not freed when they become empty.
+		 *
+		 * If allocAutoResize is false, this must not exceed allocBlockSize.
+		 *
+		 * \sa allocBlockSize
+		 * \sa allocRetainedBlocks
+		 */
+		const Size allocInitialCapacity = 0;
+
+		/*!
+		 * \brief How the data of each component is laid out in memory.
+		 *
+		 * With ComponentLayout::ArrayOfStructs, Component<T> derives from T and each component stores a whole instance of T.
+		 *
+		 * With ComponentLayout::StructOfArrays, each field listed by a specialization of ComponentFields<T>
+		 * is stored in its own array within each storage block. Component<T> does not derive from T,
+		 * fields are accessed with Component<T>::Get(V T::*), or a whole array at a time with Component<T>::FieldData().
+		 * This allows systems that only read a few fields to avoid loading the rest, and makes per-field loops easy to vectorize.
+		 *
+		 * \sa ComponentFields
+		 */
+		const ComponentLayout layout = ComponentLayout::ArrayOfStructs;
+
+		/*!
+		 * \brief Whether components should be stored without any per-instance overhead.
+		 *
+		 * By default Component<T> derives from IComponent, adding a vtable pointer and an EntityID to every instance.
+		 * For small components this can more than double the memory each instance occupies.
+		 *
+		 * If this hint is true, Component<T> does not derive from IComponent, and the entity each component is attached to
+		 * is stored in a separate array within each storage block, so each component occupies only <tt>sizeof(T)</tt> bytes.
+		 * Components can then not be used through an IComponent pointer.
+		 *
+		 * \sa ComponentTypeInfo
+		 */
+		const bool compactStorage = false;
+
+		/*!
+		 * \brief Size in bytes of a single allocation block.
+		 *
+		 * If this hint is not zero, it replaces allocBlockSize: the number of components in each storage block
+		 * is calculated at compile time as the largest number for which a whole block, including its bookkeeping,
+		 * fits within this many bytes. Blocks are aligned to their size rounded up to a power of two,
+		 * and the components within a block start on a 64-byte boundary.
+		 *
+		 * This gives every component type the same cache and TLB footprint per block regardless of <tt>sizeof(T)</tt>.
+		 * RecommendedBlockBytes is a good starting point.
+		 *
+		 * \sa allocBlockSize
+		 */
+		const Size allocBlockBytes = 0;
+
+		/*!
+		 * \brief A value for allocBlockBytes spanning four 4 KiB pages.
+		 */
+		static VLK_CXX14_CONSTEXPR Size RecommendedBlockBytes = 16 * 1024;
+
+		/*!
+		 * \brief Bytes of virtual address space to reserve for allocation blocks.
+		 *
+		 * By default each storage block is allocated from the heap separately, so blocks end up scattered in memory.
+		 *
+		 * If this hint is not zero, this many bytes of address space are reserved the first time a block is needed,
+		 * and blocks are placed one after another within it using a MappedChunkAllocator.
+		 * Memory is only committed as blocks are created. Where supported, the region is backed by transparent huge pages,
+		 * which greatly reduces TLB misses when iterating over many blocks.
+		 * Blocks that do not fit in the region are allocated from the heap.
+		 *
+		 * Reserving address space is cheap, so this can comfortably be several times the expected peak storage.
+		 *
+		 * Blocks are placed at multiples of their size rounded up to a power of two, and the gap after each block is committed as well,
+		 * so a block only slightly larger than a power of two can take up nearly twice its size.
+		 * Setting allocBlockBytes to a power of two such as RecommendedBlockBytes keeps this overhead small.
+		 *
+		 * \sa MappedChunkAllocator
+		 */
+		const Size allocRegionBytes = 0;
 	};
 
 	/*!
@@ -73,6 +193,173 @@ namespace vlk
 	template <typename T>
 	VLK_CXX14_CONSTEXPR inline ComponentHints GetComponentHints() { return ComponentHints {}; }
 
+	/*!
+	 * \brief Stands in for T as a base class of Component<T> when T uses ComponentLayout::StructOfArrays.
+	 */
+	struct SplitComponentData { };
+
+	/*!
+	 * \brief Selects the class Component<T> derives from to store its data.
+	 */
+	template <typename T>
+	struct ComponentData
+	{
+		//! T, or SplitComponentData if T's fields are stored in separate arrays.
+		typedef typename std::conditional<GetComponentHints<T>().layout == ComponentLayout::StructOfArrays, SplitComponentData, T>::type Type;
+	};
+
+	/*!
+	 * \brief Stands in for IComponent as a base class of Component<T> when T uses ComponentHints::compactStorage.
+	 */
+	struct CompactComponentBase { };
+
+	/*!
+	 * \brief Selects the class Component<T> derives from to provide type-erased access.
+	 */
+	template <typename T>
+	struct ComponentBase
+	{
+		//! IComponent, or CompactComponentBase if T's components are stored without overhead.
+		typedef typename std::conditional<GetComponentHints<T>().compactStorage, CompactComponentBase, IComponent>::type Type;
+	};
+
+	/*!
+	 * \brief Per-chunk storage used by Component<T> alongside its components.
+	 *
+	 * \tparam F The storage for split fields, FieldColumns or NoChunkColumns.
+	 * \tparam S The number of allocation spaces in the chunk.
+	 * \tparam E Whether the entity of each component is stored in the chunk.
+	 */
+	template <typename F, Size S, bool E>
+	struct ComponentColumns : public F
+	{
+		//! The entity each allocation space is attached to.
+		EntityID entities[S];
+
+		//! One more than the handle slot of each allocation space, or zero if it has none.
+		UInt handles[S];
+
+		//! The back-reference EntityIndex<Component<T>> keeps for each allocation space.
+		UInt links[S];
+	};
+
+	/*!
+	 * \copydoc vlk::ComponentColumns
+	 */
+	template <typename F, Size S>
+	struct ComponentColumns<F, S, false> : public F
+	{
+		//! One more than the handle slot of each allocation space, or zero if it has none.
+		UInt handles[S];
+
+		//! The back-reference EntityIndex<Component<T>> keeps for each allocation space.
+		UInt links[S];
+	};
+
+	/*!
+	 * \brief A reference to a component that detects when the component has been deleted.
+	 *
+	 * Handles are obtained with Component<T>::GetHandle() and turned back into a pointer with Component<T>::Resolve(ComponentHandle<T>).
+	 * Unlike a pointer, a handle stays valid if the component is moved to a different place in memory,
+	 * and resolves to <tt>nullptr</tt> once the component has been deleted, even if its memory has been reused.
+	 *
+	 * A default-constructed handle never refers to a component.
+	 *
+	 * \sa Component<T>::GetHandle()
+	 * \sa Component<T>::Resolve(ComponentHandle<T>)
+	 */
+	template <typename T>
+	struct ComponentHandle
+	{
+		//! The position of the component's entry in its type's handle table.
+		UInt index = 0;
+
+		//! The number of times the entry had been reused when the handle was created, never zero for a valid handle.
+		UInt generation = 0;
+
+		//! Returns true if this handle was default-constructed rather than obtained from a component.
+		inline bool IsNull() const { return generation == 0; }
+
+		inline bool operator==(const ComponentHandle<T>& o) const { return (index == o.index) & (generation == o.generation); }
+		inline bool operator!=(const ComponentHandle<T>& o) const { return !(*this == o); }
+	};
+
+	/*!
+	 * \brief Calculates the number of components in each storage block of Component<T>.
+	 *
+	 * \sa ComponentHints::allocBlockSize
+	 * \sa ComponentHints::allocBlockBytes
+	 */
+	template <typename T, bool UseBytes = (GetComponentHints<T>().allocBlockBytes != 0)>
+	struct ComponentChunkSize
+	{
+		//! The number of components in each storage block.
+		static VLK_CXX14_CONSTEXPR Size Value = GetComponentHints<T>().allocBlockSize;
+	};
+
+	/*!
+	 * \copydoc vlk::ComponentChunkSize
+	 */
+	template <typename T>
+	struct ComponentChunkSize<T, true>
+	{
+		private:
+		static VLK_CXX14_CONSTEXPR Size Bytes = GetComponentHints<T>().allocBlockBytes;
+
+		// Component<T> is incomplete while its chunk size is being calculated, so measure a class with the same bases instead
+		struct Probe : public ComponentBase<T>::Type, public ComponentData<T>::Type { };
+
+		template <Size S>
+		using Chunk = AllocChunk<Probe, S, ComponentColumns<typename std::conditional<GetComponentHints<T>().layout == ComponentLayout::StructOfArrays,
+			FieldColumns<typename ComponentFields<T>::Type, S>, NoChunkColumns>::type, S, GetComponentHints<T>().compactStorage>>;
+
+		// Extrapolate from the growth of a large chunk, padding can make this off by a few spaces either way
+		static VLK_CXX14_CONSTEXPR Size Estimate = (Bytes > sizeof(Chunk<1>)) ? 3 + (Bytes - sizeof(Chunk<1>)) * 512 / (sizeof(Chunk<513>) - sizeof(Chunk<1>)) : 1;
+
+		// Steps down from the estimate until a whole chunk fits
+		template <Size S, bool Fits = (S == 1) || (sizeof(Chunk<S>) <= Bytes)>
+		struct Fit
+		{
+			static VLK_CXX14_CONSTEXPR Size Value = S;
+		};
+
+		template <Size S>
+		struct Fit<S, false> : public Fit<S - 1> { };
+
+		public:
+		//! The number of components in each storage block.
+		static VLK_CXX14_CONSTEXPR Size Value = Fit<Estimate>::Value;
+	};
+
+	template <typename T, bool UseBytes>
+	VLK_CXX14_CONSTEXPR Size ComponentChunkSize<T, UseBytes>::Value;
+
+	template <typename T>
+	VLK_CXX14_CONSTEXPR Size ComponentChunkSize<T, true>::Value;
+
+	template <typename... Ts>
+	class View;
+
+	template <typename T>
+	class Component;
+
+	/*!
+	 * \brief Stores the back-reference EntityIndex<Component<T>> keeps for each component alongside it in its chunk.
+	 */
+	template <typename T>
+	struct EntityIndexLink<Component<T>>
+	{
+		static VLK_CXX14_CONSTEXPR bool Enabled = true;
+
+		static inline UInt& Of(Component<T>* c)
+		{
+			return Component<T>::LinkOf(c);
+		}
+	};
+
+	template <typename T>
+	VLK_CXX14_CONSTEXPR bool EntityIndexLink<Component<T>>::Enabled;
+
 	/*!
 	 * \brief Template class for ECS components
 	 *
@@ -83,6 +370,13 @@ namespace vlk
 	 *
 	 * Some behaviour related to Components can be controlled by specializing GetComponentHints() for T.
 	 *
+	 * Data members can be accessed directly, or with Get(V T::*), which also works when T uses ComponentLayout::StructOfArrays.
+	 *
+	 * References to components that must outlive a frame should be kept as a ComponentHandle, obtained with GetHandle(), rather than a pointer.
+	 *
+	 * A program can use at most VLK_MAX_COMPONENT_TYPES component types, 128 by default.
+	 * Attaching a component of any further type throws <tt>std::length_error</tt>, see TypeID().
+	 *
 	 * \tparam T The data this entity is storing. Ideally this would be a POD struct, but any type with at least one public constructor and a public destructor will work.
 	 *
 	 * \sa EntityID
@@ -91,210 +385,838 @@ namespace vlk
 	 * \sa GetComponentHints()
 	 */
 	template <typename T>
-	class Component final : public IComponent, public T
+	class Component final : public ComponentBase<T>::Type, public ComponentData<T>::Type
 	{
 		public:
-		static VLK_CXX14_CONSTEXPR Size ChunkSize = GetComponentHints<T>().allocBlockSize;
+		static VLK_CXX14_CONSTEXPR Size ChunkSize = ComponentChunkSize<T>::Value;
 		static VLK_CXX14_CONSTEXPR bool AllocResize = GetComponentHints<T>().allocAutoResize;
-		typedef AllocChunk<Component<T>, ChunkSize> ChunkType;
+		static VLK_CXX14_CONSTEXPR Size RetainedChunks = GetComponentHints<T>().allocRetainedBlocks;
+		static VLK_CXX14_CONSTEXPR Size InitialCapacity = GetComponentHints<T>().allocInitialCapacity;
+		static VLK_CXX14_CONSTEXPR bool SplitFields = GetComponentHints<T>().layout == ComponentLayout::StructOfArrays;
+		typedef typename ComponentFields<T>::Type FieldListType;
+		static VLK_CXX14_CONSTEXPR bool Compact = GetComponentHints<T>().compactStorage;
+		typedef typename std::conditional<SplitFields, FieldColumns<FieldListType, ChunkSize>, NoChunkColumns>::type FieldColumnsType;
+		typedef ComponentColumns<FieldColumnsType, ChunkSize, Compact> ColumnsType;
+		static VLK_CXX14_CONSTEXPR Size RegionBytes = GetComponentHints<T>().allocRegionBytes;
+		typedef typename std::conditional<RegionBytes != 0, MappedChunkAllocator<T, RegionBytes>, HeapChunkAllocator>::type AllocatorType;
+		typedef AllocChunk<Component<T>, ChunkSize, ColumnsType, AllocatorType> ChunkType;
 		//typedef typename std::vector<ChunkType*>::iterator Iterator;
 		//typedef typename std::vector<ChunkType*>::const_iterator ConstIterator;
 
 		VLK_STATIC_ASSERT_MSG(std::is_class<T>::value, "T must be a class or struct type.");
+		VLK_STATIC_ASSERT_MSG(AllocResize | (InitialCapacity <= ChunkSize), "Initial capacity cannot exceed block size when auto-resize is disabled.");
+		VLK_STATIC_ASSERT_MSG(!SplitFields | (FieldListType::Count > 0), "ComponentFields<T> must be specialized to use ComponentLayout::StructOfArrays.");
 
 		private:
+		// Views lock and iterate several component types at once
+		template <typename... Ts>
+		friend class View;
+
+		friend struct EntityIndexLink<Component<T>>;
+
 		static VLK_SHARED_MUTEX_TYPE s_mtx;
+
+		// Chunks in the range [0, s_openChunks) have free capacity, the remaining chunks are full.
 		static std::vector<ChunkType*> s_chunks;
+		static Size s_openChunks;
+
+		// Empty chunks kept for reuse, see ComponentHints::allocRetainedBlocks
+		static std::vector<ChunkType*> s_spareChunks;
+
+		// Number of chunks that are kept even when empty, see Reserve(Size)
+		static Size s_reservedChunks;
+		static bool s_initialReserved;
+
+		// Table resolving handles to components, see GetHandle()
+		struct HandleSlot
+		{
+			Component<T>* component;
+			UInt generation;
+		};
+
+		static VLK_SHARED_MUTEX_TYPE s_handleMtx;
+		static std::vector<HandleSlot> s_handleSlots;
+		static std::vector<UInt> s_freeHandles;
 
 		///////////////////////////////////////////////////////////////////////
 
+		typedef typename ComponentData<T>::Type DataType;
+
 		template <typename... Args>
 		Component<T>(Args... args) :
-			T(std::forward<Args>(args)...)
+			DataType(std::forward<Args>(args)...)
 		{ }
 
 		~Component<T>() = default;
 
 		///////////////////////////////////////////////////////////////////////
 
-		public:
-		Component<T>(const Component<T>&) = delete;
-		Component<T>(Component<T>&&) = delete;
-		Component<T>& operator=(const Component<T>&) = delete;
-		Component<T>& operator=(Component<T>&&) = delete;
-
-		///////////////////////////////////////////////////////////////////////
+		// Constructs a component in the allocation space c.
+		template <typename... Args>
+		static void Construct(Component<T>* c, Args&&... args)
+		{
+			ConstructAs(std::integral_constant<bool, SplitFields>(), c, std::forward<Args>(args)...);
+		}
 
-		/*!
-		 * \brief Creates a component.
-		 *
-		 * \param eId The entity to attach the new component to.
-		 * \param args Arguments to be forwarded to the constructor for T.
-		 *
-		 * \return A pointer to the new component.
-		 * This component should be destroyed either by calling Delete on it, or calling Entity::Delete on the entity it's attached to.
-		 *
-		 * \ts
-		 * May be called from any thread.<br>
-		 * Resource locking is handled internally.<br>
-		 * Unique access to this class is required.<br>
-		 * This function may block the calling thread.<br>
-		 *
-		 * \code{.cpp}
-		 * class MyData
-		 * {
-		 *     public:
-		 *     int foo;
-		 *
-		 *     MyData(int f) : foo(f) { }
-		 *     ~MyData() = default;
-		 * };
-		 *
-		 * EntityID eId = Entity::Create();
-		 * 
-		 * Component<MyData>* component = Component<MyData>::Create(eId, 5);
-		 * \endcode
-		 *
-		 * \sa Entity::Create()
-		 * \sa Delete()
-		 */	
 		template <typename... Args>
-		static Component<T>* Create(EntityID eId, Args... args)
+		static void ConstructAs(std::false_type, Component<T>* c, Args&&... args)
 		{
-			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+			new (c) Component<T>(std::forward<Args>(args)...);
+		}
 
+		// Fields are split, so construct a temporary and copy its fields into the chunk's columns.
+		template <typename... Args>
+		static void ConstructAs(std::true_type, Component<T>* c, Args&&... args)
+		{
 			VLK_STATIC_ASSERT_MSG((std::is_constructible<T, Args...>::value), "Cannot construct an instance of T from the provided args.");
 
-			for (auto it = s_chunks.begin(); it != s_chunks.end(); it++)
-			{
-				ChunkType* ch = *it;
-				if (!ch->Full())
-				{
-					Component<T>* c = new (ch->Allocate()) Component<T>(std::forward<Args>(args)...);
-					c->entity = eId;
-					ECRegistry<IComponent>::AddEntry(eId, static_cast<IComponent*>(c));
-					ECRegistry<Component<T>>::AddEntry(eId, c);
-					return c;
-				}
-			}
+			const T data(std::forward<Args>(args)...);
+			ChunkType* ch = ChunkType::FromPointer(c);
+			ch->Columns().Store(ch->IndexOf(c), data);
+			new (c) Component<T>();
+		}
 
-			if (AllocResize | (s_chunks.size() == 0))
-			{
-				//emplace_back returns void until C++17, so we can't use it here
-				s_chunks.push_back(new ChunkType());
-				Component<T>* c = new (s_chunks.back()->Allocate()) Component<T>(std::forward<Args>(args)...);
-				c->entity = eId;
-				ECRegistry<IComponent>::AddEntry(eId, static_cast<IComponent*>(c));
-				ECRegistry<Component<T>>::AddEntry(eId, c);
-				return c;
-			}
-			else
-			{
-				throw std::range_error("Maximum number of component allocations reached.");
-				return nullptr;
-			}
+		// Constructs a component in the allocation space dst from the data of src, leaving src to be destroyed.
+		static void MoveConstruct(Component<T>* src, Component<T>* dst)
+		{
+			MoveConstructAs(std::integral_constant<bool, SplitFields>(), src, dst);
 		}
 
-		///////////////////////////////////////////////////////////////////////
+		static void MoveConstructAs(std::false_type, Component<T>* src, Component<T>* dst)
+		{
+			new (dst) Component<T>(std::move(static_cast<T&>(*src)));
+		}
 
-		/*!
-		 * \brief Deletes this component.
-		 *
-		 * If this component is attached to an entity, it is detached.
-		 * Also calls the destructor for this object.
-		 *
-		 * \ts
-		 * May be called from any thread.<br>
-		 * Resource locking is handled internally.<br>
-		 * Unique access to this class is required.<br>
-		 * Unique access to the ECRegistry<IComponent> class is required.<br>
-		 * Unique access to the ECRegistry<Component<T>> class is required.<br>
-		 * This function may block the calling thread.<br>
-		 *
-		 * \code{.cpp}
-		 * Component<MyData>* component = Component<MyData>::Create(eId, 5);
-		 *
-		 * // Do something with component.
-		 *
-		 * component->Delete();
-		 * \endcode
-		 *
-		 * \sa Create(EntityID, Args)
-		 */
-		virtual void Delete() final override
+		static void MoveConstructAs(std::true_type, Component<T>* src, Component<T>* dst)
 		{
-			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+			ChunkType* from = ChunkType::FromPointer(src);
+			ChunkType* to = ChunkType::FromPointer(dst);
+			from->Columns().CopyTo(from->IndexOf(src), to->Columns(), to->IndexOf(dst));
+			new (dst) Component<T>();
+		}
 
-			ECRegistry<IComponent>::RemoveOne(this->entity, static_cast<IComponent*>(this));
-			ECRegistry<Component<T>>::RemoveOne(this->entity, this);
+		template <typename V>
+		inline V& GetAs(std::false_type, V T::* member)
+		{
+			return static_cast<T&>(*this).*member;
+		}
 
-			// Call destructor
-			this->~Component<T>();
+		template <typename V>
+		inline V& GetAs(std::true_type, V T::* member)
+		{
+			ChunkType* ch = ChunkType::FromPointer(this);
+			return ch->Columns().Find(member)[ch->IndexOf(this)];
+		}
 
-			// Free chunk memory
-			for (auto it = s_chunks.begin(); it != s_chunks.end(); it++)
-			{
-				ChunkType* c = *it;
+		///////////////////////////////////////////////////////////////////////
 
-				if (c->OwnsPointer(this))
-				{
-					// Free Memory occupied by this component
-					c->Deallocate(this);
+		inline EntityID GetEntityAs(std::false_type) const
+		{
+			return this->entity;
+		}
 
-					// Erase chunk if empty
-					if (c->Empty())
-					{
-						// Invalidates iterator
-						s_chunks.erase(it);
-					}
+		inline EntityID GetEntityAs(std::true_type) const
+		{
+			const ChunkType* ch = ChunkType::FromPointer(this);
+			return ch->Columns().entities[ch->IndexOf(this)];
+		}
 
-					return;
-				}
-			}
+		inline void SetEntity(EntityID eId)
+		{
+			SetEntityAs(std::integral_constant<bool, Compact>(), eId);
 		}
 
-		///////////////////////////////////////////////////////////////////////
+		inline void SetEntityAs(std::false_type, EntityID eId)
+		{
+			this->entity = eId;
+		}
+
+		inline void SetEntityAs(std::true_type, EntityID eId)
+		{
+			ChunkType* ch = ChunkType::FromPointer(this);
+			ch->Columns().entities[ch->IndexOf(this)] = eId;
+		}
+
+		// Removes this type from the signature of an entity, if no component of this type is attached to it any more.
+		// s_mtx must be uniquely locked by the caller, and the component already removed from EntityIndex<Component<T>>.
+		static inline void UnregisterSignature(EntityID eId)
+		{
+			if (EntityIndex<Component<T>>::LookupOneUnlocked(eId) == nullptr) EntitySignatures::Reset(eId, TypeID());
+		}
+
+		// Batch version of UnregisterSignature(EntityID)
+		static void UnregisterSignatures(const EntityID* ids, Size n)
+		{
+			std::vector<EntityID> cleared;
+
+			for (Size i = 0; i < n; i++)
+			{
+				if (EntityIndex<Component<T>>::LookupOneUnlocked(ids[i]) == nullptr) cleared.push_back(ids[i]);
+			}
+
+			EntitySignatures::ResetMany(cleared.data(), cleared.size(), TypeID());
+		}
+
+		// Entry in s_typeInfo
+		static void DeleteAttached(EntityID eId)
+		{
+			std::vector<Component<T>*> attached;
+			FindAll(eId, attached);
+			DeleteMany(attached.data(), attached.size());
+		}
+
+		static const ComponentTypeInfo s_typeInfo;
+
+		///////////////////////////////////////////////////////////////////////
+
+		// Returns the back-reference EntityIndex<Component<T>> keeps for c.
+		static inline UInt& LinkOf(Component<T>* c)
+		{
+			ChunkType* ch = ChunkType::FromPointer(c);
+			return ch->Columns().links[ch->IndexOf(c)];
+		}
+
+		// Returns one more than the handle slot of c, or zero if it has none.
+		static inline UInt& HandleOf(Component<T>* c)
+		{
+			ChunkType* ch = ChunkType::FromPointer(c);
+			return ch->Columns().handles[ch->IndexOf(c)];
+		}
+
+		// Invalidates every handle to c, and frees its slot for reuse.
+		// s_mtx must be uniquely locked by the caller.
+		static void ReleaseHandle(Component<T>* c)
+		{
+			UInt& h = HandleOf(c);
+			if (h == 0) return;
+
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_handleMtx);
+
+			HandleSlot& slot = s_handleSlots[h - 1];
+			slot.component = nullptr;
+
+			// Generation zero is reserved for null handles
+			if (++slot.generation == 0) slot.generation = 1;
+
+			s_freeHandles.push_back(h - 1);
+			h = 0;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		// Swaps two chunks in s_chunks, keeping their owner indices up to date.
+		static void SwapChunks(Size a, Size b)
+		{
+			std::swap(s_chunks[a], s_chunks[b]);
+			s_chunks[a]->SetOwnerIndex(a);
+			s_chunks[b]->SetOwnerIndex(b);
+		}
+
+		// Moves the chunk at index i from the full partition of s_chunks to the open partition.
+		// Returns the new index of the chunk.
+		static Size MarkOpen(Size i)
+		{
+			SwapChunks(i, s_openChunks);
+			return s_openChunks++;
+		}
+
+		// Returns the number of chunks required to store n components.
+		static VLK_CXX14_CONSTEXPR Size ChunksFor(Size n)
+		{
+			return (n + ChunkSize - 1) / ChunkSize;
+		}
+
+		// Ensures at least count chunks are allocated, adding new ones to the spare pool,
+		// and stops that many chunks from being freed when they become empty.
+		// s_mtx must be uniquely locked by the caller.
+		static void ReserveChunks(Size count)
+		{
+			s_chunks.reserve(count);
+			s_spareChunks.reserve(count);
+
+			for (Size total = s_chunks.size() + s_spareChunks.size(); total < count; total++)
+			{
+				s_spareChunks.push_back(ChunkType::Create());
+			}
+
+			if (count > s_reservedChunks) s_reservedChunks = count;
+		}
+
+		// Reserves space for a component in an open chunk, creating a new chunk if necessary.
+		// s_mtx must be uniquely locked by the caller.
+		VLK_NODISCARD static Component<T>* AllocateSlot()
+		{
+			if (s_openChunks == 0)
+			{
+				if (!AllocResize & (s_chunks.size() != 0))
+				{
+					throw std::range_error("Maximum number of component allocations reached.");
+				}
+
+				if (!s_initialReserved)
+				{
+					s_initialReserved = true;
+					ReserveChunks(ChunksFor(InitialCapacity));
+				}
+
+				if (s_spareChunks.empty())
+				{
+					s_chunks.push_back(ChunkType::Create());
+				}
+				else
+				{
+					s_chunks.push_back(s_spareChunks.back());
+					s_spareChunks.pop_back();
+				}
+
+				s_chunks.back()->SetOwnerIndex(s_chunks.size() - 1);
+				MarkOpen(s_chunks.size() - 1);
+			}
+
+			ChunkType* ch = s_chunks[s_openChunks - 1];
+			Component<T>* c = ch->Allocate();
+
+			if (ch->Full())
+			{// Last open chunk sits on the partition boundary, so no swap is needed
+				s_openChunks--;
+			}
+
+			return c;
+		}
+
+		// Returns space reserved by AllocateSlot, retiring the owning chunk if it becomes empty.
+		// s_mtx must be uniquely locked by the caller.
+		static void ReleaseSlot(Component<T>* c)
+		{
+			ReleaseHandle(c);
+
+			// Chunks are aligned to a power of two, so the owner is found by masking the address
+			ChunkType* ch = ChunkType::FromPointer(c);
+			Size i = ch->GetOwnerIndex();
+
+			bool wasFull = ch->Full();
+			ch->Deallocate(c);
+
+			if (wasFull)
+			{
+				i = MarkOpen(i);
+			}
+
+			if (ch->Empty())
+			{// Move to the partition boundary, then swap with the back so both partitions stay intact
+				SwapChunks(i, --s_openChunks);
+				SwapChunks(s_openChunks, s_chunks.size() - 1);
+				s_chunks.pop_back();
+
+				if ((s_spareChunks.size() < RetainedChunks) | (s_chunks.size() + s_spareChunks.size() < s_reservedChunks))
+				{
+					s_spareChunks.push_back(ch);
+				}
+				else
+				{
+					ChunkType::Destroy(ch);
+				}
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		public:
+		Component<T>(const Component<T>&) = delete;
+		Component<T>(Component<T>&&) = delete;
+		Component<T>& operator=(const Component<T>&) = delete;
+		Component<T>& operator=(Component<T>&&) = delete;
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Creates a component.
+		 *
+		 * \param eId The entity to attach the new component to.
+		 * \param args Arguments to be forwarded to the constructor for T.
+		 *
+		 * \return A pointer to the new component.
+		 * This component should be destroyed either by calling Delete on it, or calling Entity::Delete on the entity it's attached to.
+		 *
+		 * \throws std::length_error If this type would exceed VLK_MAX_COMPONENT_TYPES, in which case no component is created.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * class MyData
+		 * {
+		 *     public:
+		 *     int foo;
+		 *
+		 *     MyData(int f) : foo(f) { }
+		 *     ~MyData() = default;
+		 * };
+		 *
+		 * EntityID eId = Entity::Create();
+		 * 
+		 * Component<MyData>* component = Component<MyData>::Create(eId, 5);
+		 * \endcode
+		 *
+		 * \sa Entity::Create()
+		 * \sa Delete()
+		 */	
+		template <typename... Args>
+		static Component<T>* Create(EntityID eId, Args... args)
+		{
+			// Registers the type first, so running out of type IDs cannot leave a component behind
+			Size typeId = TypeID();
+
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			VLK_STATIC_ASSERT_MSG((std::is_constructible<T, Args...>::value), "Cannot construct an instance of T from the provided args.");
+
+			Component<T>* c = AllocateSlot();
+
+			try
+			{
+				Construct(c, std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				ReleaseSlot(c);
+				throw;
+			}
+
+			c->SetEntity(eId);
+			EntityIndex<Component<T>>::AddEntry(eId, c);
+			EntitySignatures::Set(eId, typeId);
+			return c;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Creates several components at once.
+		 *
+		 * Creates one component for each of the <tt>n</tt> entities in <tt>ids</tt>.
+		 * This is equivalent to calling Create(EntityID, Args...) <tt>n</tt> times,
+		 * but every lock involved is acquired only once and the new components are packed into as few storage blocks as possible.
+		 *
+		 * If any component cannot be created, every component created by this call is destroyed before the exception is rethrown.
+		 * If this type would exceed VLK_MAX_COMPONENT_TYPES, <tt>std::length_error</tt> is thrown before any component is created.
+		 *
+		 * \param out An array of at least <tt>n</tt> elements that receives a pointer to each new component.
+		 * \param ids An array of <tt>n</tt> entities to attach the new components to.
+		 * \param n The number of components to create.
+		 * \param args Arguments to be passed to the constructor of every new instance of T. These are copied, not forwarded.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * Unique access to the EntitySignatures shard of each entity involved is required.<br>
+		 * Unique access to the EntityIndex<Component<T>> class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * std::vector<EntityID> particles = ...;
+		 * std::vector<Component<Particle>*> components(particles.size());
+		 *
+		 * Component<Particle>::CreateMany(components.data(), particles.data(), particles.size(), 1.0f);
+		 * \endcode
+		 *
+		 * \sa Create(EntityID, Args...)
+		 * \sa DeleteMany(Component<T>**, Size)
+		 */
+		template <typename... Args>
+		static void CreateMany(Component<T>** out, const EntityID* ids, Size n, Args... args)
+		{
+			// Registers the type first, so running out of type IDs cannot leave components behind
+			Size typeId = TypeID();
+
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			VLK_STATIC_ASSERT_MSG((std::is_constructible<T, Args&...>::value), "Cannot construct an instance of T from the provided args.");
+
+			Size i = 0;
+
+			try
+			{
+				for (; i < n; i++)
+				{
+					Component<T>* c = AllocateSlot();
+
+					try
+					{
+						Construct(c, args...);
+					}
+					catch (...)
+					{
+						ReleaseSlot(c);
+						throw;
+					}
+
+					c->SetEntity(ids[i]);
+					out[i] = c;
+				}
+			}
+			catch (...)
+			{
+				while (i > 0)
+				{
+					Component<T>* c = out[--i];
+					c->~Component<T>();
+					ReleaseSlot(c);
+				}
+
+				throw;
+			}
+
+			EntityIndex<Component<T>>::AddEntries(ids, out, n);
+			EntitySignatures::SetMany(ids, n, typeId);
+		}
+
+		/*!
+		 * \brief Creates several components at once.
+		 *
+		 * \copydetails CreateMany(Component<T>**, const EntityID*, Size, Args...)
+		 */
+		template <typename... Args>
+		static void CreateMany(const EntityID* ids, Size n, Args... args)
+		{
+			std::vector<Component<T>*> out(n);
+			CreateMany(out.data(), ids, n, args...);
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Deletes this component.
+		 *
+		 * If this component is attached to an entity, it is detached.
+		 * Also calls the destructor for this object.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * Unique access to the EntitySignatures shard of each entity involved is required.<br>
+		 * Unique access to the EntityIndex<Component<T>> class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * Component<MyData>* component = Component<MyData>::Create(eId, 5);
+		 *
+		 * // Do something with component.
+		 *
+		 * component->Delete();
+		 * \endcode
+		 *
+		 * \sa Create(EntityID, Args)
+		 */
+		void Delete()
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			EntityID eId = GetEntity();
+			EntityIndex<Component<T>>::RemoveOne(eId, this);
+			UnregisterSignature(eId);
+
+			// Call destructor
+			this->~Component<T>();
+
+			// Free chunk memory
+			ReleaseSlot(this);
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Deletes several components at once.
+		 *
+		 * This is equivalent to calling Delete() on each of the <tt>n</tt> components in <tt>comps</tt>,
+		 * but every lock involved is acquired only once.
+		 *
+		 * \param comps An array of <tt>n</tt> distinct components to delete.
+		 * \param n The number of components to delete.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * Unique access to the EntitySignatures shard of each entity involved is required.<br>
+		 * Unique access to the EntityIndex<Component<T>> class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa Delete()
+		 * \sa CreateMany(Component<T>**, const EntityID*, Size, Args...)
+		 */
+		static void DeleteMany(Component<T>** comps, Size n)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			std::vector<EntityID> ids(n);
+
+			for (Size i = 0; i < n; i++)
+			{
+				ids[i] = comps[i]->GetEntity();
+			}
+
+			EntityIndex<Component<T>>::RemoveEntries(ids.data(), comps, n);
+			UnregisterSignatures(ids.data(), n);
+
+			for (Size i = 0; i < n; i++)
+			{
+				comps[i]->~Component<T>();
+				ReleaseSlot(comps[i]);
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Attaches this component to an entity.
+		 *
+		 * \param eId The entity to attach this component to.
+		 *
+		 * A component can only be attached to one entity at a time,
+		 * if this component is already attached to an entity when Attach is called,
+		 * it is detached from that entity and attached to the new one.
+		 * Components cannot exist detached from an entity.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * Unique access to the EntitySignatures shard of each entity involved is required.<br>
+		 * Unique access to the EntityIndex<Component<T>> class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * EntityID e1 = Entity::Create();
+		 * EntityID e2 = Entity::Create();
+		 *
+		 * Component<MyData>* component = Component<MyData>::Create(e1);
+		 * component->Attach(e2);
+		 * \endcode
+		 *
+		 * \sa Entity::Create()
+		 * \sa Entity::Global
+		 * \sa FindOne(EntityID)
+		 */
+		void Attach(EntityID eId)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			EntityID old = GetEntity();
+			SetEntity(eId);
+
+			EntityIndex<Component<T>>::Move(old, eId, this);
+			UnregisterSignature(old);
+			EntitySignatures::Set(eId, TypeID());
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Gets the id of the Entity this component is attached to.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		inline EntityID GetEntity() const
+		{
+			return GetEntityAs(std::integral_constant<bool, Compact>());
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns a handle that refers to this component.
+		 *
+		 * The handle can be stored in place of a pointer and turned back into one with Resolve(ComponentHandle<T>).
+		 * Unlike a pointer, it can be resolved safely after this component has been deleted, and resolves to <tt>nullptr</tt> if it has.
+		 * Every call for the same component returns the same handle.
+		 *
+		 * Handles are tracked in a table with one entry per component that has a handle.
+		 * Entries are created the first time this function is called on a component, and are reused once the component is deleted.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This component must not be deleted concurrently.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * ComponentHandle<Transform> target = Component<Transform>::FindOne(enemy)->GetHandle();
+		 *
+		 * // Some frames later
+		 * if (Component<Transform>* t = Component<Transform>::Resolve(target))
+		 * {
+		 *     ...
+		 * }
+		 * \endcode
+		 *
+		 * \sa Resolve(ComponentHandle<T>)
+		 * \sa ComponentHandle
+		 */
+		ComponentHandle<T> GetHandle()
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_handleMtx);
+
+			UInt& h = HandleOf(this);
+
+			if (h == 0)
+			{
+				UInt i;
+
+				if (s_freeHandles.empty())
+				{
+					i = static_cast<UInt>(s_handleSlots.size());
+					s_handleSlots.push_back(HandleSlot { this, 1 });
+				}
+				else
+				{
+					i = s_freeHandles.back();
+					s_freeHandles.pop_back();
+					s_handleSlots[i].component = this;
+				}
+
+				h = i + 1;
+			}
+
+			ComponentHandle<T> handle;
+			handle.index = h - 1;
+			handle.generation = s_handleSlots[h - 1].generation;
+			return handle;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns the component a handle refers to.
+		 *
+		 * \return The component <tt>handle</tt> was obtained from.
+		 * \return <tt>nullptr</tt> if <tt>handle</tt> is null, or the component it refers to has been deleted.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to the handle table is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa GetHandle()
+		 */
+		VLK_NODISCARD static Component<T>* Resolve(ComponentHandle<T> handle)
+		{
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_handleMtx);
+
+			if (handle.index >= s_handleSlots.size()) return nullptr;
+
+			const HandleSlot& slot = s_handleSlots[handle.index];
+			return (slot.generation == handle.generation) ? slot.component : nullptr;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns the table of type-erased functions for this component type.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function does not block the calling thread.<br>
+		 *
+		 * \sa TypeID()
+		 */
+		static inline const ComponentTypeInfo& TypeInfo()
+		{
+			return s_typeInfo;
+		}
+
+		///////////////////////////////////////////////////////////////////////
 
 		/*!
-		 * \brief Attaches this component to an entity.
+		 * \brief Returns the dense ID of this component type.
 		 *
-		 * \param eId The entity to attach this component to.
+		 * IDs are assigned in the order types are first used, starting at zero,
+		 * so the same type may have a different ID from one run of a program to the next.
 		 *
-		 * A component can only be attached to one entity at a time,
-		 * if this component is already attached to an entity when Attach is called,
-		 * it is detached from that entity and attached to the new one.
-		 * Components cannot exist detached from an entity.
+		 * \throws std::length_error If more than VLK_MAX_COMPONENT_TYPES component types are used, 128 by default.
+		 * Define VLK_MAX_COMPONENT_TYPES as a larger multiple of 64 to allow more.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function may block the calling thread the first time it is called.<br>
+		 *
+		 * \sa EntitySignatures
+		 */
+		static Size TypeID()
+		{
+			static const Size id = EntitySignatures::RegisterType(&s_typeInfo);
+			return id;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns true if at least one component of this type is attached to an entity.
+		 *
+		 * This only tests a bit in the entity's signature, and is cheaper than FindOne(EntityID).
 		 *
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Unique access to this class is required.<br>
-		 * Unique access to the ECRegistry<IComponent> class is required.<br>
-		 * Unique access to the ECRegistry<Component<T>> class is required.<br>
+		 * Shared access to the EntitySignatures shard containing <tt>eId</tt> is required.<br>
 		 * This function may block the calling thread.<br>
 		 *
-		 * \code{.cpp}
-		 * EntityID e1 = Entity::Create();
-		 * EntityID e2 = Entity::Create();
+		 * \sa FindOne(EntityID)
+		 */
+		VLK_NODISCARD static inline bool Has(EntityID eId)
+		{
+			return EntitySignatures::Test(eId, TypeID());
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns a reference to one of this component's data members.
 		 *
-		 * Component<MyData>* component = Component<MyData>::Create(e1);
-		 * component->Attach(e2);
+		 * This works regardless of the layout selected by ComponentHints::layout, so it can be used by code that must support both.
+		 * With ComponentLayout::ArrayOfStructs this is equivalent to <tt>this->*member</tt>.
+		 *
+		 * \param member A pointer to a data member of T.
+		 *
+		 * \throws std::out_of_range If T uses ComponentLayout::StructOfArrays and <tt>member</tt> is not listed in ComponentFields<T>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * This function does not block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * Component<Particle>::ForEach([](Component<Particle>* c)
+		 * {
+		 *     c->Get(&Particle::y) -= 9.8f;
+		 * });
 		 * \endcode
 		 *
-		 * \sa Entity::Create()
-		 * \sa Entity::Global
-		 * \sa FindOne(EntityID)
+		 * \sa ComponentFields
+		 * \sa FieldData()
 		 */
-		void Attach(EntityID eId)
+		template <typename V>
+		inline V& Get(V T::* member)
 		{
-			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
-			ECRegistry<IComponent>::RemoveOne(this->entity, static_cast<IComponent*>(this));
-			ECRegistry<Component<T>>::RemoveOne(this->entity, this);
-
-			this->entity = eId;
+			return GetAs(std::integral_constant<bool, SplitFields>(), member);
+		}
 
-			ECRegistry<IComponent>::AddEntry(this->entity, static_cast<IComponent*>(this));
-			ECRegistry<Component<T>>::AddEntry(this->entity, this);
+		/*!
+		 * \copydoc Get(V T::*)
+		 */
+		template <typename V>
+		inline const V& Get(V T::* member) const
+		{
+			return const_cast<Component<T>*>(this)->Get(member);
 		}
 
 		///////////////////////////////////////////////////////////////////////
@@ -307,66 +1229,337 @@ namespace vlk
 		 * If multiple components of this type are attached to the given entity,
 		 * no guarantees are made as to which component will be returned.
 		 *
+		 * Components are found through the sparse set kept by EntityIndex<Component<T>>,
+		 * so this takes constant time regardless of how many components or entities exist.
+		 * The lookup does not take any lock, so many threads can call this at once without contending.
+		 *
+		 * The returned component is only guaranteed to exist until another thread deletes it, attaches it to a different entity,
+		 * or moves it with Defragment(Size). Use GetHandle() to keep track of a component across calls to Defragment(Size).
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * No resource locking is required.<br>
+		 * This function does not block the calling thread.<br>
+		 * The returned pointer is invalidated by Defragment(Size), which must not run while it is in use.<br>
+		 *
+		 * \code{.cpp}
+		 * Component<MyData>* component = Component<MyData>::FindOne(entity);
+		 * \endcode
+		 *
+		 * \sa Attach(EntityID)
+		 * \sa FindAll(EntityID)
+		 */
+		VLK_NODISCARD static inline Component<T>* FindOne(EntityID id)
+		{
+			return EntityIndex<Component<T>>::LookupOne(id);
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Find components attached to an entity.
+		 *
+		 * \param id The entity to find components for.
+		 *
+		 * \param vecOut A vector to write the found components to.
+		 * Existing contents are not modified, but the vector may be resized.
+		 *
+		 * \return The number of components appended to vecOut
+		 *
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Shared access to the ECRegistry<Component<T>> class is required.<br>
+		 * Shared access to the EntityIndex<Component<T>> class is required.<br>
 		 * This function may block the calling thread.<br>
 		 *
 		 * \code{.cpp}
-		 * Component<MyData>* component = Component<MyData>::FindOne(entity);
+		 * std::vector<Component<MyData>*> components;
+		 * Component<MyData>::FindAll(entity, components);
+		 *
+		 * for (Component<MyData>* : components)
+		 * {
+		 *     ...
+		 * }
+		 * \endcode
+		 *
+		 * \sa Attach(EntityID)
+		 * \sa FindOne(EntityID)
+		 */
+		static inline Size FindAll(EntityID id, std::vector<Component<T>*>& vecOut)
+		{
+			return EntityIndex<Component<T>>::LookupAll(id, vecOut);
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Find a component attached to each of several entities.
+		 *
+		 * Equivalent to calling FindOne(EntityID) for each entity, but faster for large batches,
+		 * as the lookups share the setup cost and the memory for later lookups is prefetched while earlier ones complete.
+		 * Results are written in the same order as <tt>ids</tt>.
+		 *
+		 * \param ids An array of <tt>n</tt> entities to find components for. Entities may appear more than once.
+		 * \param n The number of entities in <tt>ids</tt>.
+		 * \param out An array of at least <tt>n</tt> elements.
+		 * <tt>out[i]</tt> receives one component of this type attached to <tt>ids[i]</tt>, or <tt>nullptr</tt> if there is none.
+		 *
+		 * \return The number of entities a component was found for.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * No resource locking is required.<br>
+		 * This function does not block the calling thread.<br>
+		 * The pointers written to <tt>out</tt> are invalidated by Defragment(Size), which must not run while they are in use.<br>
+		 *
+		 * \code{.cpp}
+		 * std::vector<EntityID> targets = ...;
+		 * std::vector<Component<Health>*> health(targets.size());
+		 *
+		 * Component<Health>::FindMany(targets.data(), targets.size(), health.data());
+		 * \endcode
+		 *
+		 * \sa FindOne(EntityID)
+		 */
+		static inline Size FindMany(const EntityID* ids, Size n, Component<T>** out)
+		{
+			return EntityIndex<Component<T>>::LookupMany(ids, n, out);
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Performs a mutating function on every instance of this component.
+		 *
+		 * \param func A function object that returns void and accepts a single pointer to a Component<T>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * struct MyData
+		 * {
+		 *     int foo = 0;
+		 *     bool bar = false;
+		 * };
+		 *
+		 * Component<MyData>::ForEach([](Component<MyData*> c)
+		 * {
+		 *     if (c->bar)
+		 *     {
+		 *        c->foo = 15;
+		 *     }
+		 * });
+		 *
+		 * \endcode
+		 *
+		 * \sa vlk::Component<T>::CForEach(std::function<void(const Component<T>*)>)
+		 * \sa vlk::Component<T>::ForEach(std::function<void(Iterator begin, Iterator end)>)
+		 */
+		static void ForEach(std::function<void(Component<T>*)> func)
+		{
+			ForEach<std::function<void(Component<T>*)>&>(func);
+		}
+
+		/*!
+		 * \brief Performs a mutating function on every instance of this component.
+		 *
+		 * Behaves identically to ForEach(std::function<void(Component<T>*)>), but calls <tt>func</tt> directly
+		 * instead of through a <tt>std::function</tt>, allowing the compiler to inline it into the loop.
+		 * This overload is chosen automatically when passing a lambda.
+		 *
+		 * \param func A function object that can be called with a single pointer to a Component<T>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa ForEach(std::function<void(Component<T>*)>)
+		 */
+		template <typename F>
+		static void ForEach(F&& func)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			for (auto it = s_chunks.begin(); it != s_chunks.end(); it++)
+			{
+				//Dereference here to avoid ambiguity
+				ChunkType* ch = *it;
+
+				ch->ForEachOccupied([&func, ch](Size i) { func(ch->At(i)); });
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Performs a non-mutating function on every instance of this component.
+		 *
+		 * \param func A function object that returns void and accepts a single pointer to a const Component<T>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * struct MyData
+		 * {
+		 *     bool bar = false;
+		 * };
+		 *
+		 * std::vector<const Component<MyData*>> components;
+		 *
+		 * Component<MyData>::CForEach([](const Component<MyData*> c)
+		 * {
+		 *     if (c->foo) components.insert_back(c);
+		 * });
+		 * \endcode
+		 *
+		 * \sa ForEach(std::function<void(Component<T>*)>)
+		 */
+		static void CForEach(std::function<void(const Component<T>*)> func)
+		{
+			CForEach<std::function<void(const Component<T>*)>&>(func);
+		}
+
+		/*!
+		 * \brief Performs a non-mutating function on every instance of this component.
+		 *
+		 * Behaves identically to CForEach(std::function<void(const Component<T>*)>), but calls <tt>func</tt> directly
+		 * instead of through a <tt>std::function</tt>, allowing the compiler to inline it into the loop.
+		 * This overload is chosen automatically when passing a lambda.
+		 *
+		 * \param func A function object that can be called with a single pointer to a const Component<T>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa CForEach(std::function<void(const Component<T>*)>)
+		 */
+		template <typename F>
+		static void CForEach(F&& func)
+		{
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_mtx);
+
+			for (auto it = s_chunks.cbegin(); it != s_chunks.cend(); it++)
+			{
+				//Dereference here to avoid ambiguity
+				const ChunkType* ch = *it;
+
+				ch->ForEachOccupied([&func, ch](Size i) { func(ch->At(i)); });
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Performs a mutating function on every instance of this component, using multiple threads.
+		 *
+		 * Storage blocks are divided into groups of <tt>grainChunks</tt> blocks, which are then processed in parallel
+		 * by the threads of ThreadPool::Global() and the calling thread. This function returns once every instance has been visited.
+		 *
+		 * <tt>func</tt> may be called concurrently for different components, so any state it shares must be synchronized.
+		 * <tt>func</tt> must not call any other function of this class.
+		 *
+		 * \param func A function object that can be called with a single pointer to a Component<T>.
+		 * \param grainChunks The number of storage blocks processed by each task. Larger values reduce scheduling overhead, smaller values balance load better.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function blocks the calling thread until all instances have been visited.<br>
+		 *
+		 * \code{.cpp}
+		 * Component<Transform>::ParallelForEach([dt](Component<Transform>* c)
+		 * {
+		 *     c->position += c->velocity * dt;
+		 * });
 		 * \endcode
 		 *
-		 * \sa Attach(EntityID)
-		 * \sa FindAll(EntityID)
+		 * \sa CParallelForEach(F&&, Size)
+		 * \sa ForEach(F&&)
+		 * \sa ThreadPool
 		 */
-		VLK_NODISCARD static inline Component<T>* FindOne(EntityID id)
+		template <typename F>
+		static void ParallelForEach(F&& func, Size grainChunks = 1)
 		{
-			return ECRegistry<Component<T>>::LookupOne(id);
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			if (grainChunks == 0) grainChunks = 1;
+
+			ThreadPool::Global().ParallelFor((s_chunks.size() + grainChunks - 1) / grainChunks, [&func, grainChunks](Size task)
+			{
+				Size end = std::min(s_chunks.size(), (task + 1) * grainChunks);
+
+				for (Size c = task * grainChunks; c < end; c++)
+				{
+					ChunkType* ch = s_chunks[c];
+					ch->ForEachOccupied([&func, ch](Size i) { func(ch->At(i)); });
+				}
+			});
 		}
 
 		///////////////////////////////////////////////////////////////////////
 
 		/*!
-		 * \brief Find components attached to an entity.
-		 *
-		 * \param id The entity to find components for.
+		 * \brief Performs a non-mutating function on every instance of this component, using multiple threads.
 		 *
-		 * \param vecOut A vector to write the found components to.
-		 * Existing contents are not modified, but the vector may be resized.
+		 * Behaves like ParallelForEach(F&&, Size), but only requires shared access to this class,
+		 * so it may run alongside other non-mutating functions.
 		 *
-		 * \return The number of components appended to vecOut
+		 * \param func A function object that can be called with a single pointer to a const Component<T>.
+		 * \param grainChunks The number of storage blocks processed by each task.
 		 *
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Shared access to the ECRegistry<Component<T>> class is required.<br>
-		 * This function may block the calling thread.<br>
-		 *
-		 * \code{.cpp}
-		 * std::vector<Component<MyData>*> components;
-		 * Component<MyData>::FindMany(entity, components);
-		 *
-		 * for (Component<MyData>* : components)
-		 * {
-		 *     ...
-		 * }
-		 * \endcode
+		 * Shared access to this class is required.<br>
+		 * This function blocks the calling thread until all instances have been visited.<br>
 		 *
-		 * \sa Attach(EntityID)
-		 * \sa FindOne(EntityID)
+		 * \sa ParallelForEach(F&&, Size)
+		 * \sa CForEach(F&&)
 		 */
-		static inline Size FindAll(EntityID id, std::vector<Component<T>*>& vecOut)
+		template <typename F>
+		static void CParallelForEach(F&& func, Size grainChunks = 1)
 		{
-			return ECRegistry<Component<T>>::LookupAll(id, vecOut);
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_mtx);
+
+			if (grainChunks == 0) grainChunks = 1;
+
+			ThreadPool::Global().ParallelFor((s_chunks.size() + grainChunks - 1) / grainChunks, [&func, grainChunks](Size task)
+			{
+				Size end = std::min(s_chunks.size(), (task + 1) * grainChunks);
+
+				for (Size c = task * grainChunks; c < end; c++)
+				{
+					const ChunkType* ch = s_chunks[c];
+					ch->ForEachOccupied([&func, ch](Size i) { func(ch->At(i)); });
+				}
+			});
 		}
 
 		///////////////////////////////////////////////////////////////////////
 
 		/*!
-		 * \brief Performs a mutating function on every instance of this component.
+		 * \brief Performs a mutating function on every storage block of this component.
 		 *
-		 * \param func A function object that returns void and accepts a single pointer to a Component<T>.
+		 * <tt>func</tt> is called once for each storage block that contains at least one component,
+		 * and is given a ChunkSpan covering every allocation space in the block along with its occupation bits.
+		 * This allows a system to process a whole block at a time, such as with SIMD instructions,
+		 * masking out the results for unoccupied spaces.
+		 *
+		 * \param func A function object that accepts a single ChunkSpan<Component<T>>.
 		 *
 		 * \ts
 		 * May be called from any thread.<br>
@@ -375,50 +1568,36 @@ namespace vlk
 		 * This function may block the calling thread.<br>
 		 *
 		 * \code{.cpp}
-		 * struct MyData
-		 * {
-		 *     int foo = 0;
-		 *     bool bar = false;
-		 * };
-		 *
-		 * Component<MyData>::ForEach([](Component<MyData*> c)
+		 * Component<Velocity>::ForEachChunk([](ChunkSpan<Component<Velocity>> span)
 		 * {
-		 *     if (c->bar)
+		 *     for (Size i = 0; i < span.size; i++)
 		 *     {
-		 *        c->foo = 15;
+		 *         // Unoccupied spaces are safe to skip over, but not to dereference
+		 *         if (span.IsOccupied(i)) span.data[i].y -= 9.8f;
 		 *     }
 		 * });
-		 *
 		 * \endcode
 		 *
-		 * \sa vlk::Component<T>::CForEach(std::function<void(const Component<T>*)>)
-		 * \sa vlk::Component<T>::ForEach(std::function<void(Iterator begin, Iterator end)>)
+		 * \sa CForEachChunk(F&&)
+		 * \sa ForEach(F&&)
 		 */
-		static void ForEach(std::function<void(Component<T>*)> func)
+		template <typename F>
+		static void ForEachChunk(F&& func)
 		{
 			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
 
 			for (auto it = s_chunks.begin(); it != s_chunks.end(); it++)
 			{
-				//Dereference here to avoid ambiguity
-				ChunkType* ch = *it;
-
-				for (Size i = 0; i < ChunkType::ChunkSize; i++)
-				{
-					if (ch->IsOccupied(i))
-					{
-						func(ch->At(i));
-					}
-				}
+				func((*it)->Span());
 			}
 		}
 
 		///////////////////////////////////////////////////////////////////////
 
 		/*!
-		 * \brief Performs a non-mutating function on every instance of this component.
+		 * \brief Performs a non-mutating function on every storage block of this component.
 		 *
-		 * \param func A function object that returns void and accepts a single pointer to a const Component<T>.
+		 * \param func A function object that accepts a single ChunkSpan<const Component<T>>.
 		 *
 		 * \ts
 		 * May be called from any thread.<br>
@@ -426,39 +1605,68 @@ namespace vlk
 		 * Shared access to this class is required.<br>
 		 * This function may block the calling thread.<br>
 		 *
-		 * \code{.cpp}
-		 * struct MyData
-		 * {
-		 *     bool bar = false;
-		 * };
+		 * \sa ForEachChunk(F&&)
+		 */
+		template <typename F>
+		static void CForEachChunk(F&& func)
+		{
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_mtx);
+
+			for (auto it = s_chunks.cbegin(); it != s_chunks.cend(); it++)
+			{
+				const ChunkType* ch = *it;
+				func(ch->Span());
+			}
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns the array storing one field for every allocation space of a storage block.
 		 *
-		 * std::vector<const Component<MyData*>> components;
+		 * Only available when T uses ComponentLayout::StructOfArrays.
+		 * Element <tt>i</tt> of the returned array belongs to <tt>span.data[i]</tt>, and should be ignored if that space is unoccupied.
+		 * Arrays are aligned to 64 bytes.
 		 *
-		 * Component<MyData>::CForEach([](const Component<MyData*> c)
+		 * \param span A span passed to a function by ForEachChunk(F&&).
+		 * \param member A pointer to a data member of T listed in ComponentFields<T>.
+		 *
+		 * \throws std::out_of_range If <tt>member</tt> is not listed in ComponentFields<T>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * This function does not block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * Component<Particle>::ForEachChunk([dt](ChunkSpan<Component<Particle>> span)
 		 * {
-		 *     if (c->foo) components.insert_back(c);
+		 *     Float* y = Component<Particle>::FieldData(span, &Particle::y);
+		 *     const Float* vy = Component<Particle>::FieldData(span, &Particle::vy);
+		 *
+		 *     // Unoccupied spaces hold garbage, but it is harmless to process them
+		 *     for (Size i = 0; i < span.size; i++) y[i] += vy[i] * dt;
 		 * });
 		 * \endcode
 		 *
-		 * \sa ForEach(std::function<void(Component<T>*)>)
+		 * \sa ForEachChunk(F&&)
+		 * \sa Get(V T::*)
 		 */
-		static void CForEach(std::function<void(const Component<T>*)> func)
+		template <typename V>
+		static inline V* FieldData(const ChunkSpan<Component<T>>& span, V T::* member)
 		{
-			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_mtx);
-
-			for (auto it = s_chunks.cbegin(); it != s_chunks.cend(); it++)
-			{
-				//Dereference here to avoid ambiguity
-				const ChunkType* ch = *it;
+			VLK_STATIC_ASSERT_MSG(SplitFields, "FieldData requires ComponentLayout::StructOfArrays.");
+			return ChunkType::FromPointer(span.data)->Columns().Find(member);
+		}
 
-				for (Size i = 0; i < ChunkType::ChunkSize; i++)
-				{
-					if (ch->IsOccupied(i))
-					{
-						func(ch->At(i));
-					}
-				}
-			}
+		/*!
+		 * \copydoc FieldData(const ChunkSpan<Component<T>>&, V T::*)
+		 */
+		template <typename V>
+		static inline const V* FieldData(const ChunkSpan<const Component<T>>& span, V T::* member)
+		{
+			VLK_STATIC_ASSERT_MSG(SplitFields, "FieldData requires ComponentLayout::StructOfArrays.");
+			return static_cast<const ChunkType*>(ChunkType::FromPointer(span.data))->Columns().Find(member);
 		}
 
 		///////////////////////////////////////////////////////////////////////
@@ -494,7 +1702,13 @@ namespace vlk
 		static Size Count()
 		{
 			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_mtx);
+			return CountUnlocked();
+		}
 
+		private:
+		// s_mtx must be locked by the caller.
+		static Size CountUnlocked()
+		{
 			Size total = 0;
 
 			for (auto it = s_chunks.cbegin(); it != s_chunks.cend(); it++)
@@ -505,6 +1719,7 @@ namespace vlk
 			return total;
 		}
 
+		public:
 		///////////////////////////////////////////////////////////////////////
 		
 		/*!
@@ -527,13 +1742,285 @@ namespace vlk
 		}
 
 		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Returns the number of empty storage blocks being kept for reuse.
+		 *
+		 * These blocks are not included in ChunkCount().
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa ComponentHints::allocRetainedBlocks
+		 * \sa ShrinkToFit()
+		 */
+		static Size SpareChunkCount()
+		{
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(s_mtx);
+			return s_spareChunks.size();
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Pre-allocates storage for components.
+		 *
+		 * Allocates enough storage blocks for <tt>n</tt> components to exist at once
+		 * without any further memory being allocated. Components that already exist count towards <tt>n</tt>.
+		 * Reserved storage blocks are kept even when they become empty, until ShrinkToFit() is called.
+		 *
+		 * Use this to move the cost of allocating storage to a convenient time, such as while loading a level.
+		 *
+		 * \param n The number of components to reserve storage for.
+		 *
+		 * \throws std::range_error If <tt>GetComponentHints<T>().allocAutoResize</tt> is false and
+		 * <tt>n</tt> is greater than <tt>GetComponentHints<T>().allocBlockSize</tt>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * // Enough projectiles for the whole level
+		 * Component<Projectile>::Reserve(5000);
+		 * \endcode
+		 *
+		 * \sa ComponentHints::allocInitialCapacity
+		 * \sa ShrinkToFit()
+		 */
+		static void Reserve(Size n)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			if (!AllocResize & (n > ChunkSize))
+			{
+				throw std::range_error("Cannot reserve more components than fit in a single block.");
+			}
+
+			ReserveChunks(ChunksFor(n));
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Frees every empty storage block being kept for reuse.
+		 *
+		 * Storage blocks that contain components are not affected.
+		 * This also releases any reservation made with Reserve(Size).
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa ComponentHints::allocRetainedBlocks
+		 * \sa SpareChunkCount()
+		 */
+		static void ShrinkToFit()
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			for (auto it = s_spareChunks.begin(); it != s_spareChunks.end(); it++)
+			{
+				ChunkType::Destroy(*it);
+			}
+
+			s_spareChunks.clear();
+			s_spareChunks.shrink_to_fit();
+			s_reservedChunks = 0;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+
+		/*!
+		 * \brief Moves components out of sparsely occupied storage blocks into densely occupied ones.
+		 *
+		 * After many components are deleted, their storage blocks can be left partially empty,
+		 * and functions such as ForEach(F&&) still have to visit every one of them.
+		 * This function repeatedly moves components from the emptiest partially filled block into the fullest,
+		 * so blocks are either filled or emptied. Emptied blocks are then retained or freed as if their last component had been deleted.
+		 *
+		 * At most <tt>maxMoves</tt> components are moved, so compaction can be spread across several frames.
+		 * Compaction is complete once this function moves fewer than <tt>maxMoves</tt> components.
+		 *
+		 * Moved components are constructed from an rvalue reference to the old instance of T, which is then destroyed.
+		 * Registry entries and handles obtained with GetHandle() are updated to refer to the new location,
+		 * but any other pointer to a moved component becomes invalid.
+		 *
+		 * \param maxMoves The maximum number of components to move.
+		 *
+		 * \return The number of components that were moved.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * Unique access to the EntityIndex<Component<T>> class is required.<br>
+		 * No pointers to components of this type may be in use by other threads,
+		 * including pointers returned by the lock-free FindOne(EntityID) and FindMany(const EntityID*, Size, Component<T>**).<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \code{.cpp}
+		 * // Once per frame
+		 * Component<Projectile>::Defragment(256);
+		 * \endcode
+		 *
+		 * \sa GetHandle()
+		 * \sa ChunkCount()
+		 */
+		static Size Defragment(Size maxMoves)
+		{
+			VLK_STATIC_ASSERT_MSG(SplitFields || std::is_move_constructible<T>::value, "T must be move-constructible to be defragmented.");
+
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(s_mtx);
+
+			Size moved = 0;
+			std::vector<EntityID> ids;
+			std::vector<Component<T>*> from;
+			std::vector<Component<T>*> to;
+
+			while ((moved < maxMoves) & (s_openChunks > 1))
+			{
+				// Only open chunks are worth compacting, pick the emptiest as the source and the fullest as the destination
+				Size src = 0;
+				Size dst = 0;
+				Size srcCount = ChunkSize;
+				Size dstCount = 0;
+
+				for (Size i = 0; i < s_openChunks; i++)
+				{
+					Size count = s_chunks[i]->Count();
+
+					if (count < srcCount)
+					{
+						src = i;
+						srcCount = count;
+					}
+
+					if (count >= dstCount)
+					{
+						dst = i;
+						dstCount = count;
+					}
+				}
+
+				ChunkType* srcChunk = s_chunks[src];
+				ChunkType* dstChunk = s_chunks[dst];
+				Size n = std::min(std::min(maxMoves - moved, srcCount), ChunkSize - dstCount);
+
+				ids.clear();
+				from.clear();
+				to.clear();
+
+				for (Size i : srcChunk->Occupied())
+				{
+					if (from.size() == n) break;
+					from.push_back(srcChunk->At(i));
+				}
+
+				std::exception_ptr error;
+
+				{
+					std::unique_lock<VLK_SHARED_MUTEX_TYPE> hlock(s_handleMtx);
+
+					for (Size i = 0; i < n; i++)
+					{
+						Component<T>* c = from[i];
+						Component<T>* d = dstChunk->Allocate();
+
+						try
+						{
+							MoveConstruct(c, d);
+						}
+						catch (...)
+						{
+							dstChunk->Deallocate(d);
+							error = std::current_exception();
+							break;
+						}
+
+						d->SetEntity(c->GetEntity());
+
+						// Handles follow the component to its new location
+						UInt& h = HandleOf(c);
+
+						if (h != 0)
+						{
+							s_handleSlots[h - 1].component = d;
+							HandleOf(d) = h;
+							h = 0;
+						}
+
+						ids.push_back(c->GetEntity());
+						to.push_back(d);
+					}
+				}
+
+				from.resize(to.size());
+
+				if (dstChunk->Full())
+				{// Move to the full partition
+					SwapChunks(dstChunk->GetOwnerIndex(), --s_openChunks);
+				}
+
+				// The index is updated before the old instances are destroyed, so lookups always find a live component
+				EntityIndex<Component<T>>::ReplaceEntries(ids.data(), from.data(), to.data(), to.size());
+
+				for (Component<T>* c : from)
+				{
+					c->~Component<T>();
+					ReleaseSlot(c);
+				}
+
+				moved += to.size();
+
+				if (error) std::rethrow_exception(error);
+			}
+
+			return moved;
+		}
+
+		///////////////////////////////////////////////////////////////////////
 	};
 
+	template <typename T>
+	VLK_CXX14_CONSTEXPR Size Component<T>::ChunkSize;
+
 	template <typename T>
 	VLK_SHARED_MUTEX_TYPE Component<T>::s_mtx;
 
 	template <typename T>
 	std::vector<typename Component<T>::ChunkType*> Component<T>::s_chunks;
+
+	template <typename T>
+	Size Component<T>::s_openChunks = 0;
+
+	template <typename T>
+	std::vector<typename Component<T>::ChunkType*> Component<T>::s_spareChunks;
+
+	template <typename T>
+	Size Component<T>::s_reservedChunks = 0;
+
+	template <typename T>
+	bool Component<T>::s_initialReserved = false;
+
+	template <typename T>
+	VLK_SHARED_MUTEX_TYPE Component<T>::s_handleMtx;
+
+	template <typename T>
+	std::vector<typename Component<T>::HandleSlot> Component<T>::s_handleSlots;
+
+	template <typename T>
+	std::vector<UInt> Component<T>::s_freeHandles;
+
+	template <typename T>
+	const ComponentTypeInfo Component<T>::s_typeInfo = { &Component<T>::DeleteAttached };
 }
 
 #endif
@@ -0,0 +1,242 @@
+/*!
+ * \file ComponentFields.hpp
+ * \brief Provides field lists used to store components as structures of arrays.
+ */
+
+#ifndef VLK_COMPONENT_FIELDS_HPP
+#define VLK_COMPONENT_FIELDS_HPP
+
+#include "ValkyrieEngine/ValkyrieDefs.hpp"
+
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/*!
+ * \def VLK_FIELD(type, member)
+ * \brief Names a data member of a class for use in a FieldList.
+ *
+ * \param type The class the member belongs to.
+ * \param member The name of the data member.
+ *
+ * \sa vlk::FieldList
+ * \sa vlk::ComponentFields
+ */
+#define VLK_FIELD(type, member) ::vlk::Field<decltype(&type::member), &type::member>
+
+namespace vlk
+{
+	/*!
+	 * \brief Describes a single data member of a class.
+	 *
+	 * Use the VLK_FIELD macro rather than naming this template directly.
+	 *
+	 * \tparam M A pointer-to-data-member type.
+	 * \tparam P The pointer to the data member being described.
+	 *
+	 * \sa VLK_FIELD
+	 */
+	template <typename M, M P>
+	struct Field;
+
+	/*!
+	 * \copydoc vlk::Field
+	 */
+	template <typename V, typename T, V T::* P>
+	struct Field<V T::*, P>
+	{
+		//! The type of the data member.
+		typedef V ValueType;
+
+		//! The class the data member belongs to.
+		typedef T ClassType;
+
+		//! Returns the pointer to the data member.
+		static VLK_CXX14_CONSTEXPR V T::* Pointer() { return P; }
+	};
+
+	/*!
+	 * \brief A list of data members, each named with VLK_FIELD.
+	 *
+	 * \sa ComponentFields
+	 */
+	template <typename... Fs>
+	struct FieldList
+	{
+		//! The number of fields in this list.
+		static VLK_CXX14_CONSTEXPR Size Count = sizeof...(Fs);
+	};
+
+	template <typename... Fs>
+	VLK_CXX14_CONSTEXPR Size FieldList<Fs...>::Count;
+
+	/*!
+	 * \brief Lists the data members of T that are stored when T is used with ComponentLayout::StructOfArrays.
+	 *
+	 * Specialize this for any type whose hints select ComponentLayout::StructOfArrays.
+	 * Members that are not listed are not stored.
+	 * Every listed member must be trivially copyable.
+	 *
+	 * \code{.cpp}
+	 * struct Particle
+	 * {
+	 *     Float x, y, z;
+	 * };
+	 *
+	 * namespace vlk
+	 * {
+	 *     template <>
+	 *     struct ComponentFields<Particle>
+	 *     {
+	 *         typedef FieldList<VLK_FIELD(Particle, x), VLK_FIELD(Particle, y), VLK_FIELD(Particle, z)> Type;
+	 *     };
+	 * }
+	 * \endcode
+	 *
+	 * \sa ComponentHints::layout
+	 * \sa VLK_FIELD
+	 */
+	template <typename T>
+	struct ComponentFields
+	{
+		//! The FieldList describing T.
+		typedef FieldList<> Type;
+	};
+
+	/*!
+	 * \brief Per-chunk storage holding one array for each field in a FieldList.
+	 *
+	 * Used as the column type of AllocChunk by components stored with ComponentLayout::StructOfArrays.
+	 * Each array is aligned to a 64-byte boundary.
+	 *
+	 * \tparam L A FieldList.
+	 * \tparam S The number of elements in each array.
+	 *
+	 * \sa ComponentFields
+	 */
+	template <typename L, Size S>
+	class FieldColumns;
+
+	/*!
+	 * \copydoc vlk::FieldColumns
+	 */
+	template <typename... Fs, Size S>
+	class FieldColumns<FieldList<Fs...>, S>
+	{
+		template <typename V>
+		struct alignas(64) Column
+		{
+			VLK_STATIC_ASSERT_MSG(std::is_trivially_copyable<V>::value, "Fields stored in columns must be trivially copyable.");
+			VLK_STATIC_ASSERT_MSG(alignof(V) <= 64, "Fields stored in columns must not be over-aligned.");
+
+			typename std::aligned_storage<sizeof(V), alignof(V)>::type data[S];
+		};
+
+		std::tuple<Column<typename Fs::ValueType>...> columns;
+
+		// Points out at the column for field I if it describes member
+		template <Size I, typename V, typename T>
+		typename std::enable_if<std::is_same<V T::*, decltype(std::tuple_element<I, std::tuple<Fs...>>::type::Pointer())>::value>::type
+		Match(V T::* member, V*& out)
+		{
+			if (std::tuple_element<I, std::tuple<Fs...>>::type::Pointer() == member) out = Data<I>();
+		}
+
+		// Fields of a different type can never match
+		template <Size I, typename V, typename T>
+		typename std::enable_if<!std::is_same<V T::*, decltype(std::tuple_element<I, std::tuple<Fs...>>::type::Pointer())>::value>::type
+		Match(V T::*, V*&)
+		{ }
+
+		template <typename V, typename T, Size... I>
+		V* Find(V T::* member, std::index_sequence<I...>)
+		{
+			V* out = nullptr;
+			int expand[] = { 0, (Match<I>(member, out), 0)... };
+			(void)expand;
+
+			if (out == nullptr) throw std::out_of_range("Member is not part of the component's field list.");
+			return out;
+		}
+
+		template <typename T, Size... I>
+		void Store(Size i, const T& src, std::index_sequence<I...>)
+		{
+			int expand[] = { 0, (new (Data<I>() + i) typename Fs::ValueType(src.*(Fs::Pointer())), 0)... };
+			(void)expand;
+		}
+
+		template <Size... I>
+		void CopyTo(Size i, FieldColumns& dst, Size j, std::index_sequence<I...>) const
+		{
+			int expand[] = { 0, (new (dst.Data<I>() + j) typename Fs::ValueType(Data<I>()[i]), 0)... };
+			(void)expand;
+		}
+
+		public:
+		//! The type of field I.
+		template <Size I>
+		using ValueType = typename std::tuple_element<I, std::tuple<Fs...>>::type::ValueType;
+
+		/*!
+		 * \brief Returns a pointer to the first element of the array storing field I.
+		 */
+		template <Size I>
+		inline ValueType<I>* Data()
+		{
+			return reinterpret_cast<ValueType<I>*>(&std::get<I>(columns).data[0]);
+		}
+
+		/*!
+		 * \copydoc Data()
+		 */
+		template <Size I>
+		inline const ValueType<I>* Data() const
+		{
+			return reinterpret_cast<const ValueType<I>*>(&std::get<I>(columns).data[0]);
+		}
+
+		/*!
+		 * \brief Returns a pointer to the first element of the array storing <tt>member</tt>.
+		 *
+		 * When <tt>member</tt> is known at compile time, the search is resolved by the compiler.
+		 *
+		 * \throws std::out_of_range If <tt>member</tt> is not part of the field list.
+		 */
+		template <typename V, typename T>
+		inline V* Find(V T::* member)
+		{
+			return Find(member, std::index_sequence_for<Fs...>());
+		}
+
+		/*!
+		 * \copydoc Find(V T::*)
+		 */
+		template <typename V, typename T>
+		inline const V* Find(V T::* member) const
+		{
+			return const_cast<FieldColumns*>(this)->Find(member, std::index_sequence_for<Fs...>());
+		}
+
+		/*!
+		 * \brief Copies every listed field of <tt>src</tt> into position <tt>i</tt> of the arrays.
+		 */
+		template <typename T>
+		inline void Store(Size i, const T& src)
+		{
+			Store(i, src, std::index_sequence_for<Fs...>());
+		}
+
+		/*!
+		 * \brief Copies every field at position <tt>i</tt> of these arrays into position <tt>j</tt> of the arrays in <tt>dst</tt>.
+		 */
+		inline void CopyTo(Size i, FieldColumns& dst, Size j) const
+		{
+			CopyTo(i, dst, j, std::index_sequence_for<Fs...>());
+		}
+	};
+}
+
+#endif
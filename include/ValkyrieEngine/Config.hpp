@@ -295,6 +295,22 @@ namespace vlk
 	#else
 		#define VLK_IS_DEBUG false
 	#endif
+
+	/*!
+	 * \def VLK_MAX_COMPONENT_TYPES
+	 * \brief A macro used to set the maximum number of component types a program can use, should expand to a multiple of 64.
+	 *
+	 * Every entity stores one bit per component type in its ComponentSignature, so raising this costs 8 bytes per entity for each further 64 types.
+	 * Using more component types than this throws <tt>std::length_error</tt> from Component<T>::TypeID(). Defaults to 128.
+	 *
+	 * The same value must be used for the engine and everything that includes its headers,
+	 * so you should set this by passing an appropriate flag to your compiler, or with the CMake cache variable of the same name.
+	 *
+	 * \sa ComponentSignature::Capacity
+	 */
+	#ifndef VLK_MAX_COMPONENT_TYPES
+		#define VLK_MAX_COMPONENT_TYPES 128
+	#endif
 }
 
 #endif //VLK_CONFIG_H
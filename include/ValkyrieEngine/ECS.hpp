@@ -7,8 +7,10 @@
 #define VLK_ENTITYID_HPP
 
 #include "ValkyrieEngine/ValkyrieDefs.hpp"
+#include "ValkyrieEngine/Util.hpp"
 
-#include <unordered_map>
+#include <algorithm>
+#include <mutex>
 #include <shared_mutex>
 #include <vector>
 
@@ -24,15 +26,210 @@ namespace vlk
 	/*!
 	 * \brief Tracks what components are attached to what entities.
 	 *
-	 * Direct use is generally discouraged, consider using the wrappers available in Component<T> and Entity instead.
+	 * Associations are stored in a flat open-addressing hash table with one slot per entity,
+	 * so adding and removing associations does not allocate once the table has grown to size.
+	 * Each slot holds the first two components associated with its entity inline,
+	 * further components are kept in a list owned by the slot.
+	 *
+	 * The table is split into 16 shards by the low bits of the entity ID, each with its own table and lock,
+	 * so threads creating or deleting components on different entities rarely wait on each other.
+	 *
+	 * \deprecated Nothing in the engine uses this class any more.
+	 * Component<T> tracks its components with EntityIndex, and entities track their component types with EntitySignatures.
+	 * It is kept only for code that uses it directly, and will be removed in a future version.
 	 *
 	 * \tparam C The component type the registry is tracking.
+	 *
+	 * \sa EntityIndex
+	 * \sa EntitySignatures
 	 */
 	template <typename C>
 	class ECRegistry
 	{
-		static std::unordered_multimap<EntityID, C*> reg;
-		static VLK_SHARED_MUTEX_TYPE mtx;
+		static VLK_CXX14_CONSTEXPR UInt InlineCount = 2;
+		static VLK_CXX14_CONSTEXPR Size MinCapacity = 16;
+		static VLK_CXX14_CONSTEXPR Size ShardCount = 16;
+
+		// Every component associated with a single entity
+		struct Slot
+		{
+			EntityID entity = 0;
+			UInt count = 0; // 0 if the slot is empty
+			C* local[InlineCount];
+			std::vector<C*> spill;
+
+			inline C*& At(UInt i)
+			{
+				return (i < InlineCount) ? local[i] : spill[i - InlineCount];
+			}
+
+			inline void Push(C* component)
+			{
+				if (count < InlineCount) local[count] = component;
+				else spill.push_back(component);
+				count++;
+			}
+
+			// Moves the last component into position i
+			inline void Erase(UInt i)
+			{
+				UInt last = count - 1;
+				At(i) = At(last);
+				if (last >= InlineCount) spill.pop_back();
+				count = last;
+			}
+
+			inline UInt IndexOf(C* component)
+			{
+				for (UInt i = 0; i < count; i++)
+				{
+					if (At(i) == component) return i;
+				}
+
+				return count;
+			}
+		};
+
+		// A hash table holding the entities whose IDs share the same low bits.
+		// Aligned to a cache line so that locking one shard does not contend with its neighbours.
+		struct alignas(64) Shard
+		{
+			std::vector<Slot> slots;
+			Size used = 0;
+			Size shift = 64;
+			VLK_SHARED_MUTEX_TYPE mtx;
+
+			// Fibonacci hashing, entity IDs are sequential so the low bits alone would cluster
+			inline Size Home(EntityID entity) const
+			{
+				return static_cast<Size>((entity * 0x9E3779B97F4A7C15ull) >> shift);
+			}
+
+			inline Size Mask() const
+			{
+				return slots.size() - 1;
+			}
+
+			// Returns the index of the slot of an entity, or slots.size() if it has none
+			Size Find(EntityID entity) const
+			{
+				if (slots.empty()) return 0;
+
+				for (Size i = Home(entity);; i = (i + 1) & Mask())
+				{
+					if (slots[i].count == 0) return slots.size();
+					if (slots[i].entity == entity) return i;
+				}
+			}
+
+			void Rehash(Size capacity)
+			{
+				std::vector<Slot> old(capacity);
+				old.swap(slots);
+				shift = 64 - CountTrailingZeros(capacity);
+
+				for (auto it = old.begin(); it != old.end(); it++)
+				{
+					if (it->count == 0) continue;
+
+					Size i = Home(it->entity);
+					while (slots[i].count != 0) i = (i + 1) & Mask();
+					slots[i] = std::move(*it);
+				}
+			}
+
+			// Grows the table so that n more entities can be added without rehashing
+			void Reserve(Size n)
+			{
+				// Keep the load factor at or below 3/4
+				Size capacity = std::max(MinCapacity, slots.size());
+				while ((used + n) * 4 > capacity * 3) capacity *= 2;
+				if (capacity != slots.size()) Rehash(capacity);
+			}
+
+			void Insert(EntityID entity, C* component)
+			{
+				Reserve(1);
+
+				Size i = Home(entity);
+
+				while ((slots[i].count != 0) && (slots[i].entity != entity))
+				{
+					i = (i + 1) & Mask();
+				}
+
+				if (slots[i].count == 0)
+				{
+					slots[i].entity = entity;
+					used++;
+				}
+
+				slots[i].Push(component);
+			}
+
+			// Empties a slot, shifting back any later slots in the same probe sequence so lookups never need tombstones
+			void EraseSlot(Size i)
+			{
+				for (Size j = (i + 1) & Mask(); slots[j].count != 0; j = (j + 1) & Mask())
+				{
+					Size home = Home(slots[j].entity);
+
+					// Slot j can move back to i if its home position is not cyclically within (i, j]
+					bool stays = (i <= j) ? ((i < home) && (home <= j)) : ((i < home) || (home <= j));
+
+					if (!stays)
+					{
+						slots[i] = std::move(slots[j]);
+						i = j;
+					}
+				}
+
+				slots[i].count = 0;
+				slots[i].spill.clear();
+				used--;
+			}
+
+			void Erase(EntityID entity, C* component)
+			{
+				Size i = Find(entity);
+				if (i == slots.size()) return;
+
+				UInt index = slots[i].IndexOf(component);
+				if (index == slots[i].count) return;
+
+				slots[i].Erase(index);
+				if (slots[i].count == 0) EraseSlot(i);
+			}
+
+			void Replace(EntityID entity, C* from, C* to)
+			{
+				Size i = Find(entity);
+				if (i == slots.size()) return;
+
+				UInt index = slots[i].IndexOf(from);
+				if (index != slots[i].count) slots[i].At(index) = to;
+			}
+		};
+
+		static Shard shards[ShardCount];
+
+		static inline Shard& ShardOf(EntityID entity)
+		{
+			return shards[entity & (ShardCount - 1)];
+		}
+
+		// Returns a mask with bit s set if any of the entities belong to shard s
+		static inline UInt ShardsOf(const EntityID* entities, Size n)
+		{
+			UInt mask = 0;
+
+			for (Size i = 0; i < n; i++)
+			{
+				mask |= 1u << (entities[i] & (ShardCount - 1));
+			}
+
+			return mask;
+		}
 
 		public:
 
@@ -44,7 +241,7 @@ namespace vlk
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Unique access to this class is required.<br>
+		 * Unique access to the shard of this class containing <tt>entity</tt> is required.<br>
 		 * This function may block the calling thread<br> 
 		 *
 		 * \sa RemoveOne(EntityID, C*)
@@ -52,25 +249,52 @@ namespace vlk
 		 */
 		static void AddEntry(EntityID entity, C* component)
 		{
-			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+			Shard& shard = ShardOf(entity);
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shard.mtx);
+			shard.Insert(entity, component);
+		}
 
-			/* I don't think this will ever come into play?
-			{// Erase existing entry if exists
-				auto search = reg.equal_range(entity);
+		/*!
+		 * \brief Batch association insertion function.
+		 *
+		 * Associates <tt>components[i]</tt> with <tt>entities[i]</tt> for every <tt>i</tt> less than <tt>n</tt>.
+		 * Equivalent to calling AddEntry(EntityID, C*) for each pair, but only acquires each shard's lock once.
+		 *
+		 * \tparam D A type that is implicitly convertible to C*.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to each shard of this class is required in turn.<br>
+		 * This function may block the calling thread<br> 
+		 *
+		 * \sa AddEntry(EntityID, C*)
+		 * \sa Component<T>::CreateMany(const EntityID*, Size, Args...)
+		 */
+		template <typename D>
+		static void AddEntries(const EntityID* entities, D* const* components, Size n)
+		{
+			Size counts[ShardCount] = {};
+
+			for (Size i = 0; i < n; i++)
+			{
+				counts[entities[i] & (ShardCount - 1)]++;
+			}
+
+			for (Size s = 0; s < ShardCount; s++)
+			{
+				if (counts[s] == 0) continue;
 
-				for (auto it = search.first; it != search.second; it++)
+				std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shards[s].mtx);
+
+				// Grow once up front rather than doubling repeatedly
+				shards[s].Reserve(counts[s]);
+
+				for (Size i = 0; i < n; i++)
 				{
-					if (it->second == component)
-					{
-						reg.erase(it);
-						break;
-					}
+					if ((entities[i] & (ShardCount - 1)) == s) shards[s].Insert(entities[i], static_cast<C*>(components[i]));
 				}
 			}
-			*/
-
-			// Emplace entry
-			reg.emplace(entity, component);
 		}
 
 		/*!
@@ -83,7 +307,7 @@ namespace vlk
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Unique access to this class is required.<br>
+		 * Unique access to the shard of this class containing <tt>entity</tt> is required.<br>
 		 * This function may block the calling thread<br> 
 		 *
 		 * \sa RemoveOne(EntityID, C* component)
@@ -92,8 +316,15 @@ namespace vlk
 		 */
 		static Size RemoveAll(EntityID entity)
 		{
-			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
-			return reg.erase(entity);
+			Shard& shard = ShardOf(entity);
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shard.mtx);
+
+			Size i = shard.Find(entity);
+			if (i == shard.slots.size()) return 0;
+
+			Size erased = shard.slots[i].count;
+			shard.EraseSlot(i);
+			return erased;
 		}
 
 		/*!
@@ -104,7 +335,7 @@ namespace vlk
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Unique access to this class is required.<br>
+		 * Unique access to the shard of this class containing <tt>entity</tt> is required.<br>
 		 * This function may block the calling thread<br> 
 		 *
 		 * \sa RemoveAll(EntityID)
@@ -113,18 +344,78 @@ namespace vlk
 		 */
 		static void RemoveOne(EntityID entity, C* component)
 		{
-			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+			Shard& shard = ShardOf(entity);
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shard.mtx);
+			shard.Erase(entity, component);
+		}
 
-			{// Erase existing entry if exists
-				auto search = reg.equal_range(entity);
+		/*!
+		 * \brief Batch association removal function.
+		 *
+		 * Removes the association between <tt>components[i]</tt> and <tt>entities[i]</tt> for every <tt>i</tt> less than <tt>n</tt>.
+		 * Equivalent to calling RemoveOne(EntityID, C*) for each pair, but only acquires each shard's lock once.
+		 *
+		 * \tparam D A type that is implicitly convertible to C*.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to each shard of this class is required in turn.<br>
+		 * This function may block the calling thread<br> 
+		 *
+		 * \sa RemoveOne(EntityID, C*)
+		 * \sa Component<T>::DeleteMany(Component<T>**, Size)
+		 */
+		template <typename D>
+		static void RemoveEntries(const EntityID* entities, D* const* components, Size n)
+		{
+			UInt touched = ShardsOf(entities, n);
 
-				for (auto it = search.first; it != search.second; it++)
+			for (Size s = 0; s < ShardCount; s++)
+			{
+				if ((touched & (1u << s)) == 0) continue;
+
+				std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shards[s].mtx);
+
+				for (Size i = 0; i < n; i++)
 				{
-					if (it->second == component)
-					{
-						reg.erase(it);
-						return;
-					}
+					if ((entities[i] & (ShardCount - 1)) == s) shards[s].Erase(entities[i], static_cast<C*>(components[i]));
+				}
+			}
+		}
+
+		/*!
+		 * \brief Batch association replacement function.
+		 *
+		 * Replaces the association between <tt>from[i]</tt> and <tt>entities[i]</tt> with one between <tt>to[i]</tt> and <tt>entities[i]</tt>
+		 * for every <tt>i</tt> less than <tt>n</tt>. Used when components are moved to a different address.
+		 * Equivalent to calling RemoveOne(EntityID, C*) and then AddEntry(EntityID, C*) for each pair,
+		 * but only acquires each shard's lock once and updates each association in place.
+		 *
+		 * \tparam D A type that is implicitly convertible to C*.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to each shard of this class is required in turn.<br>
+		 * This function may block the calling thread<br> 
+		 *
+		 * \sa Component<T>::Defragment(Size)
+		 */
+		template <typename D>
+		static void ReplaceEntries(const EntityID* entities, D* const* from, D* const* to, Size n)
+		{
+			UInt touched = ShardsOf(entities, n);
+
+			for (Size s = 0; s < ShardCount; s++)
+			{
+				if ((touched & (1u << s)) == 0) continue;
+
+				std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shards[s].mtx);
+
+				for (Size i = 0; i < n; i++)
+				{
+					if ((entities[i] & (ShardCount - 1)) == s) shards[s].Replace(entities[i], static_cast<C*>(from[i]), static_cast<C*>(to[i]));
 				}
 			}
 		}
@@ -137,18 +428,36 @@ namespace vlk
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Shared access to this class is required.<br>
+		 * Shared access to the shard of this class containing <tt>entity</tt> is required.<br>
 		 * This function may block the calling thread<br>
 		 *
 		 * \sa Component<T>::FindOne(EntityID)
 		 */
 		static C* LookupOne(EntityID entity)
 		{
-			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
-
-			auto it = reg.find(entity);
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(ShardOf(entity).mtx);
+			return LookupOneUnlocked(entity);
+		}
 
-			return (it == reg.end()) ? nullptr : it->second;
+		/*!
+		 * \brief Association lookup function that does not lock the registry.
+		 *
+		 * Behaves like LookupOne(EntityID), for callers that already prevent the registry from being modified,
+		 * such as by holding the lock of the only class that modifies it.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Shared access to the shard of this class containing <tt>entity</tt> is required.<br>
+		 * This function does not block the calling thread<br>
+		 *
+		 * \sa LookupOne(EntityID)
+		 */
+		static C* LookupOneUnlocked(EntityID entity)
+		{
+			Shard& shard = ShardOf(entity);
+			Size i = shard.Find(entity);
+			return (i == shard.slots.size()) ? nullptr : shard.slots[i].local[0];
 		}
 
 		/*!
@@ -168,7 +477,7 @@ namespace vlk
 		 * \ts
 		 * May be called from any thread.<br>
 		 * Resource locking is handled internally.<br>
-		 * Shared access to this class is required.<br>
+		 * Shared access to the shard of this class containing <tt>entity</tt> is required.<br>
 		 * This function may block the calling thread<br>
 		 *
 		 * \sa Component<T>::FindAll(EntityID, std::vector<Component<T>*>&)
@@ -176,27 +485,35 @@ namespace vlk
 
 		static Size LookupAll(EntityID entity, std::vector<C*>& vecOut)
 		{
-			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
+			Shard& shard = ShardOf(entity);
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(shard.mtx);
 
-			auto search = reg.equal_range(entity);
-			Size numEntries = std::distance(search.first, search.second);
+			Size i = shard.Find(entity);
+			if (i == shard.slots.size()) return 0;
 
-			vecOut.reserve(vecOut.size() + numEntries);
+			Slot& slot = shard.slots[i];
+			vecOut.reserve(vecOut.size() + slot.count);
 
-			for (auto it = search.first; it != search.second; it++)
+			for (UInt j = 0; j < slot.count; j++)
 			{
-				vecOut.push_back(it->second);
+				vecOut.push_back(slot.At(j));
 			}
 
-			return numEntries;
+			return slot.count;
 		}
 	};
 
 	template <typename C>
-	std::unordered_multimap<EntityID, C*> ECRegistry<C>::reg;
+	VLK_CXX14_CONSTEXPR UInt ECRegistry<C>::InlineCount;
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR Size ECRegistry<C>::MinCapacity;
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR Size ECRegistry<C>::ShardCount;
 
 	template <typename C>
-	VLK_SHARED_MUTEX_TYPE ECRegistry<C>::mtx;
+	typename ECRegistry<C>::Shard ECRegistry<C>::shards[ECRegistry<C>::ShardCount];
 }
 
 #endif
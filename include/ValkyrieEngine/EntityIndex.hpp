@@ -0,0 +1,723 @@
+/*!
+ * \file EntityIndex.hpp
+ * \brief Provides a sparse-set index from entities to the components attached to them.
+ */
+
+#ifndef VLK_ENTITY_INDEX_HPP
+#define VLK_ENTITY_INDEX_HPP
+
+#include "ValkyrieEngine/ECS.hpp"
+#include "ValkyrieEngine/Epoch.hpp"
+#include "ValkyrieEngine/Util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <vector>
+
+namespace vlk
+{
+	/*!
+	 * \brief Lets EntityIndex<C> keep a back-reference in each component it tracks.
+	 *
+	 * A specialization that sets <tt>Enabled</tt> to true must also provide <tt>static UInt& Of(C* component)</tt>,
+	 * returning storage within or alongside <tt>component</tt> that the index can use to remember where it keeps it.
+	 * Removing or replacing an association then takes constant time,
+	 * no matter how many components of type C are attached to the same entity.
+	 * Without a specialization, the index searches the entity's components instead.
+	 *
+	 * \tparam C The component type tracked by the index.
+	 */
+	template <typename C>
+	struct EntityIndexLink
+	{
+		//! Whether this specialization provides <tt>Of(C*)</tt>.
+		static VLK_CXX14_CONSTEXPR bool Enabled = false;
+	};
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR bool EntityIndexLink<C>::Enabled;
+
+	/*!
+	 * \brief Tracks what components of a single type are attached to what entities.
+	 *
+	 * Provides the same interface as ECRegistry, but is stored as a sparse set rather than a hash table,
+	 * so finding the components attached to an entity takes two array reads instead of hashing and probing.
+	 *
+	 * The sparse part maps each entity ID to a position in the dense part, and is split into pages of 4096 IDs.
+	 * Pages are only allocated once an entity in their range has an association, and are freed again once none do,
+	 * so memory use follows the range of IDs in use rather than the largest ID ever seen.
+	 * The dense part holds one entry for each entity with at least one association.
+	 * Entities with more than one association keep the rest in a separate list.
+	 *
+	 * Direct use is generally discouraged, consider using the wrappers available in Component<T> instead.
+	 *
+	 * \tparam C The component type the index is tracking.
+	 *
+	 * \sa ECRegistry
+	 * \sa Component<T>::FindOne(EntityID)
+	 */
+	template <typename C>
+	class EntityIndex
+	{
+		static VLK_CXX14_CONSTEXPR Size PageBits = 12;
+		static VLK_CXX14_CONSTEXPR Size PageSize = Size(1) << PageBits;
+
+		// How many entities ahead LookupMany prefetches
+		static VLK_CXX14_CONSTEXPR Size PrefetchDistance = 8;
+
+		struct Entry
+		{
+			C* first;
+			UInt extra; // Index + 1 of the list of further associations in s_extras, 0 if there are none
+		};
+
+		// Sparse part, each slot is the position + 1 of the entity in the dense part, or 0 if it has no entry
+		static std::vector<std::unique_ptr<UInt[]>> s_pages;
+		static std::vector<UInt> s_pageCounts;
+
+		// Dense part
+		static std::vector<EntityID> s_entities;
+		static std::vector<Entry> s_entries;
+
+		static std::vector<std::vector<C*>> s_extras;
+		static std::vector<UInt> s_freeExtras;
+
+		static VLK_SHARED_MUTEX_TYPE mtx;
+
+		// Lock-free copy of Entry::first for every entity, read by LookupOne(EntityID) without taking mtx.
+		// Pages match the pages of the sparse part, and are only written to while mtx is uniquely locked.
+		struct PublishedPage
+		{
+			std::atomic<C*> slots[PageSize];
+
+			PublishedPage()
+			{
+				for (Size i = 0; i < PageSize; i++)
+				{
+					slots[i].store(nullptr, std::memory_order_relaxed);
+				}
+			}
+		};
+
+		struct Directory
+		{
+			Size size;
+			std::unique_ptr<std::atomic<PublishedPage*>[]> pages;
+		};
+
+		// Replaced directories and freed pages are retired through Epoch, as readers may still be using them
+		static std::atomic<Directory*> s_published;
+
+		static void DeletePage(void* p)
+		{
+			delete static_cast<PublishedPage*>(p);
+		}
+
+		static void DeleteDirectory(void* p)
+		{
+			delete static_cast<Directory*>(p);
+		}
+
+		// Position of a component within its entity's associations, 0 for Entry::first and i + 1 for the extra list at i
+		typedef std::integral_constant<bool, EntityIndexLink<C>::Enabled> Linked;
+		static VLK_CXX14_CONSTEXPR UInt NotFound = ~UInt(0);
+
+		// Returns the position + 1 of an entity in the dense part, or 0 if it has no entry
+		static inline UInt Find(EntityID entity)
+		{
+			Size page = static_cast<Size>(entity >> PageBits);
+			if ((page >= s_pages.size()) || !s_pages[page]) return 0;
+			return s_pages[page][entity & (PageSize - 1)];
+		}
+
+		// Returns the sparse slot of an entity, allocating its page if needed.
+		// A slot that was empty must be filled by the caller.
+		static UInt& Claim(EntityID entity)
+		{
+			Size page = static_cast<Size>(entity >> PageBits);
+
+			if (page >= s_pages.size())
+			{
+				s_pages.resize(page + 1);
+				s_pageCounts.resize(page + 1, 0);
+				GrowPublished(page + 1);
+			}
+
+			if (!s_pages[page])
+			{
+				s_pages[page].reset(new UInt[PageSize]());
+				s_published.load(std::memory_order_relaxed)->pages[page].store(new PublishedPage(), std::memory_order_release);
+			}
+
+			UInt& slot = s_pages[page][entity & (PageSize - 1)];
+			if (slot == 0) s_pageCounts[page]++;
+			return slot;
+		}
+
+		// Empties the sparse slot of an entity, freeing its page if no other slot in it is in use
+		static void Unclaim(EntityID entity)
+		{
+			Size page = static_cast<Size>(entity >> PageBits);
+			s_pages[page][entity & (PageSize - 1)] = 0;
+
+			if (--s_pageCounts[page] == 0)
+			{
+				s_pages[page].reset();
+
+				std::atomic<PublishedPage*>& published = s_published.load(std::memory_order_relaxed)->pages[page];
+				PublishedPage* old = published.load(std::memory_order_relaxed);
+				published.store(nullptr, std::memory_order_release);
+				Epoch::Retire(old, &DeletePage);
+			}
+		}
+
+		// Replaces the published directory with one that holds at least n pages
+		static void GrowPublished(Size n)
+		{
+			Directory* old = s_published.load(std::memory_order_relaxed);
+			Size oldSize = (old == nullptr) ? 0 : old->size;
+			if (oldSize >= n) return;
+
+			// Grow geometrically so that directories are rarely retired
+			Size size = std::max(n, oldSize * 2);
+			Directory* d = new Directory { size, std::unique_ptr<std::atomic<PublishedPage*>[]>(new std::atomic<PublishedPage*>[size]) };
+
+			for (Size i = 0; i < size; i++)
+			{
+				d->pages[i].store((i < oldSize) ? old->pages[i].load(std::memory_order_relaxed) : nullptr, std::memory_order_relaxed);
+			}
+
+			s_published.store(d, std::memory_order_release);
+			if (old != nullptr) Epoch::Retire(old, &DeleteDirectory);
+		}
+
+		// Returns the published slot of an entity, or nullptr if its page does not exist.
+		// The caller must hold an Epoch::Guard.
+		static inline const std::atomic<C*>* PublishedSlot(Directory* d, EntityID entity)
+		{
+			Size page = static_cast<Size>(entity >> PageBits);
+			if ((d == nullptr) || (page >= d->size)) return nullptr;
+
+			PublishedPage* p = d->pages[page].load(std::memory_order_acquire);
+			return (p == nullptr) ? nullptr : &p->slots[entity & (PageSize - 1)];
+		}
+
+		// Sets the component LookupOne(EntityID) returns for an entity, whose sparse page must exist
+		static inline void Publish(EntityID entity, C* component)
+		{
+			Directory* d = s_published.load(std::memory_order_relaxed);
+			PublishedPage* p = d->pages[static_cast<Size>(entity >> PageBits)].load(std::memory_order_relaxed);
+			p->slots[entity & (PageSize - 1)].store(component, std::memory_order_release);
+		}
+
+		static inline C*& At(Entry& e, UInt pos)
+		{
+			return (pos == 0) ? e.first : s_extras[e.extra - 1][pos - 1];
+		}
+
+		static inline void SetLink(std::true_type, C* component, UInt pos)
+		{
+			EntityIndexLink<C>::Of(component) = pos;
+		}
+
+		static inline void SetLink(std::false_type, C*, UInt)
+		{ }
+
+		static inline UInt PositionOf(std::true_type, Entry& e, C* component)
+		{
+			UInt pos = EntityIndexLink<C>::Of(component);
+			bool valid = (pos == 0) || ((e.extra != 0) && (pos <= s_extras[e.extra - 1].size()));
+			return (valid && (At(e, pos) == component)) ? pos : NotFound;
+		}
+
+		static UInt PositionOf(std::false_type, Entry& e, C* component)
+		{
+			if (e.first == component) return 0;
+			if (e.extra == 0) return NotFound;
+
+			std::vector<C*>& extra = s_extras[e.extra - 1];
+			auto it = std::find(extra.begin(), extra.end(), component);
+			return (it == extra.end()) ? NotFound : static_cast<UInt>(it - extra.begin()) + 1;
+		}
+
+		static void Insert(EntityID entity, C* component)
+		{
+			UInt& slot = Claim(entity);
+
+			if (slot == 0)
+			{
+				s_entities.push_back(entity);
+				s_entries.push_back(Entry { component, 0 });
+				slot = static_cast<UInt>(s_entries.size());
+				SetLink(Linked(), component, 0);
+				Publish(entity, component);
+				return;
+			}
+
+			Entry& e = s_entries[slot - 1];
+
+			if (e.extra == 0)
+			{
+				if (s_freeExtras.empty())
+				{
+					s_extras.emplace_back();
+					e.extra = static_cast<UInt>(s_extras.size());
+				}
+				else
+				{
+					e.extra = s_freeExtras.back();
+					s_freeExtras.pop_back();
+				}
+			}
+
+			std::vector<C*>& extra = s_extras[e.extra - 1];
+			extra.push_back(component);
+			SetLink(Linked(), component, static_cast<UInt>(extra.size()));
+		}
+
+		static void ReleaseExtra(Entry& e)
+		{
+			s_freeExtras.push_back(e.extra);
+			e.extra = 0;
+		}
+
+		// Removes the dense entry at pos, which must not have any further associations
+		static void EraseEntity(EntityID entity, Size pos)
+		{
+			Size last = s_entries.size() - 1;
+
+			if (pos != last)
+			{
+				EntityID moved = s_entities[last];
+				s_entities[pos] = moved;
+				s_entries[pos] = s_entries[last];
+				s_pages[moved >> PageBits][moved & (PageSize - 1)] = static_cast<UInt>(pos + 1);
+			}
+
+			s_entities.pop_back();
+			s_entries.pop_back();
+			Publish(entity, nullptr);
+			Unclaim(entity);
+		}
+
+		static bool Erase(EntityID entity, C* component)
+		{
+			UInt slot = Find(entity);
+			if (slot == 0) return false;
+
+			Entry& e = s_entries[slot - 1];
+			UInt pos = PositionOf(Linked(), e, component);
+			if (pos == NotFound) return false;
+
+			if (e.extra == 0)
+			{
+				EraseEntity(entity, slot - 1);
+				return true;
+			}
+
+			// Fill the gap with the last association
+			std::vector<C*>& extra = s_extras[e.extra - 1];
+			UInt last = static_cast<UInt>(extra.size());
+			C* moved = extra.back();
+			extra.pop_back();
+
+			if (pos != last)
+			{
+				At(e, pos) = moved;
+				SetLink(Linked(), moved, pos);
+				if (pos == 0) Publish(entity, moved);
+			}
+
+			if (extra.empty()) ReleaseExtra(e);
+			return true;
+		}
+
+		public:
+
+		/*!
+		 * \brief Association insertion function.
+		 *
+		 * Associates a component with an entity. Does not remove any existing associations <tt>component</tt> may have.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa RemoveOne(EntityID, C*)
+		 */
+		static void AddEntry(EntityID entity, C* component)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+			Insert(entity, component);
+		}
+
+		/*!
+		 * \brief Batch association insertion function.
+		 *
+		 * Associates <tt>components[i]</tt> with <tt>entities[i]</tt> for every <tt>i</tt> less than <tt>n</tt>.
+		 * Equivalent to calling AddEntry(EntityID, C*) for each pair, but only acquires the lock once.
+		 *
+		 * \tparam D A type that is implicitly convertible to C*.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa AddEntry(EntityID, C*)
+		 */
+		template <typename D>
+		static void AddEntries(const EntityID* entities, D* const* components, Size n)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+			s_entities.reserve(s_entities.size() + n);
+			s_entries.reserve(s_entries.size() + n);
+
+			for (Size i = 0; i < n; i++)
+			{
+				Insert(entities[i], static_cast<C*>(components[i]));
+			}
+		}
+
+		/*!
+		 * \brief Association removal function.
+		 *
+		 * Removes every association an entity has with components of type C.
+		 *
+		 * \return The number of associations that have been erased.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa RemoveOne(EntityID, C*)
+		 */
+		static Size RemoveAll(EntityID entity)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+			UInt slot = Find(entity);
+			if (slot == 0) return 0;
+
+			Entry& e = s_entries[slot - 1];
+			Size erased = 1;
+
+			if (e.extra != 0)
+			{
+				erased += s_extras[e.extra - 1].size();
+				s_extras[e.extra - 1].clear();
+				ReleaseExtra(e);
+			}
+
+			EraseEntity(entity, slot - 1);
+			return erased;
+		}
+
+		/*!
+		 * \brief Association removal function.
+		 *
+		 * Removes one association an entity has with a component.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa RemoveAll(EntityID)
+		 */
+		static void RemoveOne(EntityID entity, C* component)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+			Erase(entity, component);
+		}
+
+		/*!
+		 * \brief Association transfer function.
+		 *
+		 * Moves the association of a component from one entity to another.
+		 * Equivalent to calling RemoveOne(EntityID, C*) and then AddEntry(EntityID, C*), but only acquires the lock once.
+		 * If <tt>component</tt> is the only association of <tt>from</tt> and <tt>to</tt> has none,
+		 * the existing entry is re-keyed in place rather than removed and added again.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa Component<T>::Attach(EntityID)
+		 */
+		static void Move(EntityID from, EntityID to, C* component)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+			if (from == to) return;
+
+			UInt slot = Find(from);
+
+			if ((slot != 0) && (s_entries[slot - 1].extra == 0) && (s_entries[slot - 1].first == component) && (Find(to) == 0))
+			{
+				s_entities[slot - 1] = to;
+				Claim(to) = slot;
+				Publish(to, component);
+				Publish(from, nullptr);
+				Unclaim(from);
+				return;
+			}
+
+			Erase(from, component);
+			Insert(to, component);
+		}
+
+		/*!
+		 * \brief Batch association removal function.
+		 *
+		 * Removes the association between <tt>components[i]</tt> and <tt>entities[i]</tt> for every <tt>i</tt> less than <tt>n</tt>.
+		 * Equivalent to calling RemoveOne(EntityID, C*) for each pair, but only acquires the lock once.
+		 *
+		 * \tparam D A type that is implicitly convertible to C*.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa RemoveOne(EntityID, C*)
+		 */
+		template <typename D>
+		static void RemoveEntries(const EntityID* entities, D* const* components, Size n)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+			for (Size i = 0; i < n; i++)
+			{
+				Erase(entities[i], static_cast<C*>(components[i]));
+			}
+		}
+
+		/*!
+		 * \brief Batch association replacement function.
+		 *
+		 * Replaces the association between <tt>from[i]</tt> and <tt>entities[i]</tt> with one between <tt>to[i]</tt> and <tt>entities[i]</tt>
+		 * for every <tt>i</tt> less than <tt>n</tt>, updating each association in place.
+		 *
+		 * \tparam D A type that is implicitly convertible to C*.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa Component<T>::Defragment(Size)
+		 */
+		template <typename D>
+		static void ReplaceEntries(const EntityID* entities, D* const* from, D* const* to, Size n)
+		{
+			std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+			for (Size i = 0; i < n; i++)
+			{
+				UInt slot = Find(entities[i]);
+				if (slot == 0) continue;
+
+				Entry& e = s_entries[slot - 1];
+				UInt pos = PositionOf(Linked(), e, static_cast<C*>(from[i]));
+				if (pos == NotFound) continue;
+
+				At(e, pos) = static_cast<C*>(to[i]);
+				SetLink(Linked(), static_cast<C*>(to[i]), pos);
+				if (pos == 0) Publish(entities[i], static_cast<C*>(to[i]));
+			}
+		}
+
+		/*!
+		 * \brief Association lookup function
+		 *
+		 * Reads a copy of the index that writers publish with atomic stores, so it never takes a lock,
+		 * and readers on different threads do not write to any shared memory.
+		 * Memory the copy no longer uses is freed through Epoch once no lookup can still be reading it.
+		 *
+		 * \return One component of type C that has an association
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * No resource locking is required.<br>
+		 * This function does not block the calling thread<br>
+		 * Only the index is protected by the epoch, the returned component may be destroyed once the lookup returns.<br>
+		 *
+		 * \sa Component<T>::FindOne(EntityID)
+		 */
+		static inline C* LookupOne(EntityID entity)
+		{
+			Epoch::Guard guard;
+
+			const std::atomic<C*>* slot = PublishedSlot(s_published.load(std::memory_order_acquire), entity);
+			return (slot == nullptr) ? nullptr : slot->load(std::memory_order_acquire);
+		}
+
+		/*!
+		 * \brief Batch association lookup function.
+		 *
+		 * Sets <tt>out[i]</tt> to what LookupOne(EntityID) would return for <tt>entities[i]</tt>, for every <tt>i</tt> less than <tt>n</tt>.
+		 * The epoch is only entered once for the whole batch, and the slot of each entity is prefetched
+		 * a few entities before it is read, so the cache misses of consecutive lookups overlap.
+		 *
+		 * \return The number of entities a component was found for.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * No resource locking is required.<br>
+		 * This function does not block the calling thread<br>
+		 * Only the index is protected by the epoch, the returned components may be destroyed once the lookup returns.<br>
+		 *
+		 * \sa Component<T>::FindMany(const EntityID*, Size, Component<T>**)
+		 */
+		static Size LookupMany(const EntityID* entities, Size n, C** out)
+		{
+			Epoch::Guard guard;
+
+			Directory* d = s_published.load(std::memory_order_acquire);
+			Size found = 0;
+
+			for (Size i = 0; i < n; i++)
+			{
+				if (i + PrefetchDistance < n)
+				{
+					const std::atomic<C*>* ahead = PublishedSlot(d, entities[i + PrefetchDistance]);
+					if (ahead != nullptr) Prefetch(ahead);
+				}
+
+				const std::atomic<C*>* slot = PublishedSlot(d, entities[i]);
+				out[i] = (slot == nullptr) ? nullptr : slot->load(std::memory_order_acquire);
+				found += (out[i] != nullptr);
+			}
+
+			return found;
+		}
+
+		/*!
+		 * \brief Association lookup function that does not lock the index.
+		 *
+		 * Behaves like LookupOne(EntityID), for callers that already prevent the index from being modified,
+		 * such as by holding the lock of the only class that modifies it.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking must be handled externally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function does not block the calling thread<br>
+		 *
+		 * \sa LookupOne(EntityID)
+		 * \sa View
+		 */
+		static inline C* LookupOneUnlocked(EntityID entity)
+		{
+			UInt slot = Find(entity);
+			return (slot == 0) ? nullptr : s_entries[slot - 1].first;
+		}
+
+		/*!
+		 * \brief Association lookup function.
+		 *
+		 * Retrieves all associations an entity has with components of type C.
+		 *
+		 * \param entity The entity to find associations for.
+		 *
+		 * \param vecOut A vector to write associated components to.
+		 * Associated components are inserted at the end of the vector.
+		 * Existing contents are not modified or rearranged.
+		 * May be resized to accomodate new elements.
+		 *
+		 * \return The number of components written to the vector
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 *
+		 * \sa Component<T>::FindAll(EntityID, std::vector<Component<T>*>&)
+		 */
+		static Size LookupAll(EntityID entity, std::vector<C*>& vecOut)
+		{
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
+
+			UInt slot = Find(entity);
+			if (slot == 0) return 0;
+
+			const Entry& e = s_entries[slot - 1];
+			vecOut.push_back(e.first);
+			if (e.extra == 0) return 1;
+
+			const std::vector<C*>& extra = s_extras[e.extra - 1];
+			vecOut.insert(vecOut.end(), extra.begin(), extra.end());
+			return extra.size() + 1;
+		}
+
+		/*!
+		 * \brief Returns the number of entities with at least one association.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to this class is required.<br>
+		 * This function may block the calling thread<br>
+		 */
+		static Size EntityCount()
+		{
+			std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
+			return s_entities.size();
+		}
+	};
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR Size EntityIndex<C>::PageBits;
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR Size EntityIndex<C>::PageSize;
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR Size EntityIndex<C>::PrefetchDistance;
+
+	template <typename C>
+	VLK_CXX14_CONSTEXPR UInt EntityIndex<C>::NotFound;
+
+	template <typename C>
+	std::vector<std::unique_ptr<UInt[]>> EntityIndex<C>::s_pages;
+
+	template <typename C>
+	std::vector<UInt> EntityIndex<C>::s_pageCounts;
+
+	template <typename C>
+	std::vector<EntityID> EntityIndex<C>::s_entities;
+
+	template <typename C>
+	std::vector<typename EntityIndex<C>::Entry> EntityIndex<C>::s_entries;
+
+	template <typename C>
+	std::vector<std::vector<C*>> EntityIndex<C>::s_extras;
+
+	template <typename C>
+	std::vector<UInt> EntityIndex<C>::s_freeExtras;
+
+	template <typename C>
+	VLK_SHARED_MUTEX_TYPE EntityIndex<C>::mtx;
+
+	template <typename C>
+	std::atomic<typename EntityIndex<C>::Directory*> EntityIndex<C>::s_published { nullptr };
+}
+
+#endif
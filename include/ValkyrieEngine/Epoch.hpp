@@ -0,0 +1,80 @@
+/*!
+ * \file Epoch.hpp
+ * \brief Provides epoch-based reclamation of memory shared with lock-free readers.
+ */
+
+#ifndef VLK_EPOCH_HPP
+#define VLK_EPOCH_HPP
+
+#include "ValkyrieEngine/ValkyrieDefs.hpp"
+
+namespace vlk
+{
+	/*!
+	 * \brief Defers freeing memory until no lock-free reader can still be using it.
+	 *
+	 * Readers wrap every access to shared memory in an Epoch::Guard.
+	 * A writer that unlinks memory readers may still hold a pointer to passes it to Retire(void*, DeleteFunc)
+	 * instead of freeing it immediately. The memory is freed once every guard that was active at the time has been destroyed.
+	 *
+	 * Entering and leaving a guard only touches a counter owned by the calling thread,
+	 * so readers on different threads never write to the same cache line.
+	 *
+	 * \sa EntityIndex<C>::LookupOne(EntityID)
+	 */
+	class Epoch
+	{
+		public:
+		//! A function that frees memory passed to Retire(void*, DeleteFunc).
+		typedef void (*DeleteFunc)(void*);
+
+		/*!
+		 * \brief Marks the calling thread as reading shared memory for the lifetime of the guard.
+		 *
+		 * Guards may be nested, only the outermost guard on each thread has any effect.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function does not block the calling thread, except the first time it is used on each thread.<br>
+		 */
+		class Guard
+		{
+			public:
+			Guard();
+			~Guard();
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+
+		/*!
+		 * \brief Frees memory once no Guard that was active when this was called still exists.
+		 *
+		 * Memory must already be unreachable for readers that start after this call.
+		 * Retiring memory also frees any earlier retired memory that has become safe to free.
+		 *
+		 * \param p The memory to free.
+		 * \param deleter A function that frees <tt>p</tt>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void Retire(void* p, DeleteFunc deleter);
+
+		/*!
+		 * \brief Frees any retired memory that is no longer in use.
+		 *
+		 * \return The number of retired allocations that remain to be freed.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static Size Reclaim();
+	};
+}
+
+#endif
@@ -30,6 +30,22 @@ namespace vlk
 		 */
 		virtual void Delete() = 0;
 	};
+
+	/*!
+	 * \brief Table of functions used to operate on components of one type without knowing the type.
+	 *
+	 * Each component type's table is registered with EntitySignatures under the type's dense ID,
+	 * which is how Entity::Delete(EntityID) finds the components attached to an entity,
+	 * including those stored with ComponentHints::compactStorage that do not derive from IComponent.
+	 *
+	 * \sa Component<T>::TypeInfo()
+	 * \sa Component<T>::TypeID()
+	 */
+	struct ComponentTypeInfo
+	{
+		//! Deletes every component of the described type attached to an entity.
+		void (*deleteAttached)(EntityID entity);
+	};
 }
 
 #endif
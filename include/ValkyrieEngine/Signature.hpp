@@ -0,0 +1,223 @@
+/*!
+ * \file Signature.hpp
+ * \brief Provides dense component type IDs and per-entity component signatures.
+ */
+
+#ifndef VLK_SIGNATURE_HPP
+#define VLK_SIGNATURE_HPP
+
+#include "ValkyrieEngine/ECS.hpp"
+#include "ValkyrieEngine/IComponent.hpp"
+#include "ValkyrieEngine/Util.hpp"
+
+namespace vlk
+{
+	/*!
+	 * \brief A set of component types, stored as one bit per type ID.
+	 *
+	 * \sa EntitySignatures
+	 * \sa Component<T>::TypeID()
+	 */
+	class ComponentSignature
+	{
+		public:
+		/*!
+		 * \brief The maximum number of component types that can be used in a program.
+		 *
+		 * \sa VLK_MAX_COMPONENT_TYPES
+		 */
+		static VLK_CXX14_CONSTEXPR Size Capacity = VLK_MAX_COMPONENT_TYPES;
+
+		VLK_STATIC_ASSERT_MSG((Capacity > 0) && (Capacity % 64 == 0), "VLK_MAX_COMPONENT_TYPES must be a positive multiple of 64.");
+
+		private:
+		static VLK_CXX14_CONSTEXPR Size WordCount = Capacity / 64;
+
+		ULong words[WordCount];
+
+		public:
+		//! Constructs an empty signature.
+		VLK_CXX14_CONSTEXPR ComponentSignature() : words() { }
+
+		//! Adds a type to this signature.
+		inline void Set(Size typeId)
+		{
+			words[typeId / 64] |= ULong(1) << (typeId % 64);
+		}
+
+		//! Removes a type from this signature.
+		inline void Reset(Size typeId)
+		{
+			words[typeId / 64] &= ~(ULong(1) << (typeId % 64));
+		}
+
+		//! Returns true if this signature contains a type.
+		inline bool Test(Size typeId) const
+		{
+			return (words[typeId / 64] >> (typeId % 64)) & 1;
+		}
+
+		//! Returns true if this signature contains every type in <tt>other</tt>.
+		inline bool Contains(const ComponentSignature& other) const
+		{
+			ULong missing = 0;
+
+			for (Size i = 0; i < WordCount; i++)
+			{
+				missing |= other.words[i] & ~words[i];
+			}
+
+			return missing == 0;
+		}
+
+		//! Returns true if this signature contains no types.
+		inline bool Empty() const
+		{
+			ULong any = 0;
+
+			for (Size i = 0; i < WordCount; i++)
+			{
+				any |= words[i];
+			}
+
+			return any == 0;
+		}
+
+		/*!
+		 * \brief Calls <tt>func(Size typeId)</tt> for every type in this signature, in ascending order.
+		 */
+		template <typename F>
+		void ForEach(F&& func) const
+		{
+			for (Size i = 0; i < WordCount; i++)
+			{
+				for (ULong w = words[i]; w != 0; w &= w - 1)
+				{
+					func(i * 64 + CountTrailingZeros(w));
+				}
+			}
+		}
+
+		inline bool operator==(const ComponentSignature& other) const
+		{
+			return Contains(other) && other.Contains(*this);
+		}
+
+		inline bool operator!=(const ComponentSignature& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/*!
+	 * \brief Tracks which component types are attached to each entity.
+	 *
+	 * Every component type is given a dense type ID the first time it is used, starting at zero.
+	 * Each entity has a ComponentSignature with the bit for a type set while at least one component of that type is attached to it,
+	 * which lets Entity::Delete(EntityID), Component<T>::Has(EntityID) and View<Ts...>::Matches(EntityID) work with bit operations
+	 * instead of searching a registry.
+	 *
+	 * Signatures are split into 16 shards by the low bits of the entity ID, each with its own lock,
+	 * and stored in pages of 1024 entities that are freed once every signature in them is empty.
+	 *
+	 * Direct use is generally discouraged, consider using the wrappers available in Component<T> and Entity instead.
+	 *
+	 * \sa ComponentTypeInfo
+	 */
+	class EntitySignatures
+	{
+		public:
+		/*!
+		 * \brief Assigns the next dense type ID to a component type.
+		 *
+		 * \return The new type ID.
+		 *
+		 * \throws std::length_error If ComponentSignature::Capacity types have already been registered.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa Component<T>::TypeID()
+		 */
+		static Size RegisterType(const ComponentTypeInfo* info);
+
+		/*!
+		 * \brief Returns the table of type-erased functions registered with a type ID.
+		 *
+		 * \ts
+		 * May be called from any thread, for any ID returned by RegisterType(const ComponentTypeInfo*).<br>
+		 * This function does not block the calling thread.<br>
+		 */
+		static const ComponentTypeInfo* TypeAt(Size typeId);
+
+		/*!
+		 * \brief Adds a type to the signature of an entity.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to the shard containing <tt>entity</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void Set(EntityID entity, Size typeId);
+
+		/*!
+		 * \brief Adds a type to the signature of each of <tt>n</tt> entities, acquiring each shard's lock only once.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to each shard is required in turn.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void SetMany(const EntityID* entities, Size n, Size typeId);
+
+		/*!
+		 * \brief Removes a type from the signature of an entity.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to the shard containing <tt>entity</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void Reset(EntityID entity, Size typeId);
+
+		/*!
+		 * \brief Removes a type from the signature of each of <tt>n</tt> entities, acquiring each shard's lock only once.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to each shard is required in turn.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static void ResetMany(const EntityID* entities, Size n, Size typeId);
+
+		/*!
+		 * \brief Returns true if the signature of an entity contains a type.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to the shard containing <tt>entity</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static bool Test(EntityID entity, Size typeId);
+
+		/*!
+		 * \brief Returns a copy of the signature of an entity.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to the shard containing <tt>entity</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 */
+		static ComponentSignature Get(EntityID entity);
+	};
+}
+
+#endif
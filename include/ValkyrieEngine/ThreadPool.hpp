@@ -0,0 +1,109 @@
+/*!
+ * \file ThreadPool.hpp
+ * \brief Provides a pool of worker threads for data-parallel work.
+ */
+
+#ifndef VLK_THREAD_POOL_HPP
+#define VLK_THREAD_POOL_HPP
+
+#include "ValkyrieEngine/ValkyrieDefs.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vlk
+{
+	/*!
+	 * \brief A fixed set of worker threads that cooperatively execute parallel loops.
+	 *
+	 * Most code should use the shared pool returned by Global() rather than constructing its own.
+	 *
+	 * \sa Component<T>::ParallelForEach(F&&, Size)
+	 */
+	class ThreadPool
+	{
+		// State shared between the threads taking part in one ParallelFor call
+		struct Job
+		{
+			const std::function<void(Size)>* func;
+			Size count;
+			std::atomic<Size> next;
+			std::atomic<Size> pendingHelpers;
+			std::exception_ptr error;
+			std::mutex errorMtx;
+		};
+
+		std::vector<std::thread> workers;
+		std::deque<Job*> queue;
+		std::mutex mtx;
+		std::condition_variable wake;
+		std::condition_variable done;
+		bool stopping;
+
+		static void RunJob(Job* job);
+		void WorkerMain();
+
+		public:
+		/*!
+		 * \brief Starts a pool with the given number of worker threads.
+		 *
+		 * A pool with zero workers is valid, all work is then performed by the thread calling ParallelFor.
+		 */
+		explicit ThreadPool(Size numWorkers);
+
+		/*!
+		 * \brief Stops and joins every worker thread.
+		 *
+		 * Must not be called while a call to ParallelFor is in progress.
+		 */
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		/*!
+		 * \brief Returns the engine's shared thread pool.
+		 *
+		 * The pool is created the first time this function is called,
+		 * with one worker for each hardware thread other than the calling one.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function may block the calling thread the first time it is called.<br>
+		 */
+		static ThreadPool& Global();
+
+		/*!
+		 * \brief Returns the number of worker threads in this pool.
+		 */
+		inline Size WorkerCount() const { return workers.size(); }
+
+		/*!
+		 * \brief Calls <tt>func(i)</tt> for every <tt>i</tt> in the range [0, count) using every thread in the pool.
+		 *
+		 * The calling thread takes part in the work, and this function returns once every call has finished.
+		 * No guarantees are made as to which thread runs each index or in what order.
+		 * If any call throws, the remaining indices may be skipped and the first exception is rethrown once all threads are finished.
+		 *
+		 * ParallelFor may be called from inside <tt>func</tt>.
+		 * The calling thread only ever runs indices of its own call, never work queued by other callers,
+		 * so locks held by the caller are not re-entered by unrelated work.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * This function blocks the calling thread until all work is complete.<br>
+		 */
+		void ParallelFor(Size count, const std::function<void(Size)>& func);
+	};
+}
+
+#endif
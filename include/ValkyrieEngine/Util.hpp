@@ -2,7 +2,17 @@
 #ifndef VLK_UTIL_HPP
 #define VLK_UTIL_HPP
 
+#include "ValkyrieEngine/ValkyrieDefs.hpp"
 #include <type_traits>
+#include <cstdlib>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+	#include <malloc.h>
+#endif
 
 namespace vlk
 {
@@ -37,6 +47,134 @@ namespace vlk
 	 */
 	template <template <class> class T, class S>
 	struct ExtractParameter<T<S>> { typedef S type; };
+
+	/*!
+	 * \brief Is any of template class
+	 *
+	 * <tt>value</tt> evaluates to true if <tt>T</tt> is the same type as any of <tt>Ts...</tt>.
+	 */
+	template <class T, class... Ts>
+	struct IsAnyOf : std::false_type {};
+
+	/*!
+	 * \copydoc vlk::IsAnyOf
+	 */
+	template <class T, class U, class... Ts>
+	struct IsAnyOf<T, U, Ts...> : std::integral_constant<bool, std::is_same<T, U>::value || IsAnyOf<T, Ts...>::value> {};
+
+	/*!
+	 * \brief All distinct template class
+	 *
+	 * <tt>value</tt> evaluates to true if no two of the types <tt>Ts...</tt> are the same.
+	 */
+	template <class... Ts>
+	struct AllDistinct : std::true_type {};
+
+	/*!
+	 * \copydoc vlk::AllDistinct
+	 */
+	template <class T, class... Ts>
+	struct AllDistinct<T, Ts...> : std::integral_constant<bool, !IsAnyOf<T, Ts...>::value && AllDistinct<Ts...>::value> {};
+
+	/*!
+	 * \brief Returns the index of the least significant set bit in <tt>v</tt>.
+	 *
+	 * The result is undefined if <tt>v</tt> is zero.
+	 *
+	 * \sa PopCount(ULong)
+	 */
+	inline Size CountTrailingZeros(ULong v)
+	{
+		#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<Size>(__builtin_ctzll(v));
+		#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+			unsigned long i;
+			_BitScanForward64(&i, v);
+			return static_cast<Size>(i);
+		#else
+			Size i = 0;
+			while ((v & 1) == 0) { v >>= 1; i++; }
+			return i;
+		#endif
+	}
+
+	/*!
+	 * \brief Returns the number of set bits in <tt>v</tt>.
+	 *
+	 * \sa CountTrailingZeros(ULong)
+	 */
+	inline Size PopCount(ULong v)
+	{
+		#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<Size>(__builtin_popcountll(v));
+		#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+			return static_cast<Size>(__popcnt64(v));
+		#else
+			Size i = 0;
+			for (; v != 0; i++) v &= v - 1;
+			return i;
+		#endif
+	}
+
+	/*!
+	 * \brief Returns the smallest power of two that is greater than or equal to <tt>v</tt>.
+	 */
+	VLK_CXX14_CONSTEXPR inline Size NextPowerOfTwo(Size v)
+	{
+		Size p = 1;
+		while (p < v) p <<= 1;
+		return p;
+	}
+
+	/*!
+	 * \brief Allocates <tt>size</tt> bytes of uninitialized memory aligned to <tt>alignment</tt> bytes.
+	 *
+	 * <tt>alignment</tt> must be a power of two and a multiple of <tt>sizeof(void*)</tt>.
+	 * Memory returned by this function must be released with AlignedFree(void*).
+	 *
+	 * \return A pointer to the allocated memory, or <tt>nullptr</tt> if the allocation failed.
+	 *
+	 * \sa AlignedFree(void*)
+	 */
+	inline void* AlignedAlloc(Size alignment, Size size)
+	{
+		#if defined(_WIN32)
+			return _aligned_malloc(size, alignment);
+		#else
+			void* p = nullptr;
+			return (posix_memalign(&p, alignment, size) == 0) ? p : nullptr;
+		#endif
+	}
+
+	/*!
+	 * \brief Releases memory allocated with AlignedAlloc(Size, Size).
+	 *
+	 * \sa AlignedAlloc(Size, Size)
+	 */
+	inline void AlignedFree(void* p)
+	{
+		#if defined(_WIN32)
+			_aligned_free(p);
+		#else
+			free(p);
+		#endif
+	}
+
+	/*!
+	 * \brief Hints that the cache line containing <tt>p</tt> will be read soon.
+	 *
+	 * Has no effect on compilers without a prefetch intrinsic. <tt>p</tt> does not need to point to valid memory.
+	 */
+	inline void Prefetch(const void* p)
+	{
+		#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(p);
+		#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+		#else
+			(void)p;
+		#endif
+	}
 }
 
 #endif
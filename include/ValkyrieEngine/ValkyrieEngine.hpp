@@ -7,9 +7,11 @@
 #define VLK_ENGINE_H
 
 #include "ValkyrieEngine/ValkyrieDebug.hpp"
+#include "ValkyrieEngine/Archetype.hpp"
 #include "ValkyrieEngine/Component.hpp"
 #include "ValkyrieEngine/EventBus.hpp"
 #include "ValkyrieEngine/Util.hpp"
+#include "ValkyrieEngine/View.hpp"
 
 /*!
  * \mainpage ValkyrieEngine Core
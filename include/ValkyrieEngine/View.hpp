@@ -0,0 +1,249 @@
+/*!
+ * \file View.hpp
+ * \brief Provides the View<Ts...> class for iterating entities with several component types
+ */
+
+#ifndef VLK_VIEW_HPP
+#define VLK_VIEW_HPP
+
+#include "ValkyrieEngine/Component.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace vlk
+{
+	/*!
+	 * \brief Iterates every entity that has a component of each of the types <tt>Ts...</tt>.
+	 *
+	 * A view visits the components of whichever type currently has the fewest instances,
+	 * and looks up the entity each one is attached to in the entity indices of the other types.
+	 * Every type involved is locked once for the whole iteration, rather than once per lookup as with Component<T>::FindOne(EntityID).
+	 *
+	 * If an entity has more than one component of a type, only one of them is visited for that entity,
+	 * unless that type has the fewest instances, in which case the entity is visited once for each.
+	 *
+	 * \tparam Ts The data types of the components to join, which must all be different.
+	 *
+	 * \code{.cpp}
+	 * View<Transform, Velocity>::ForEach([dt](Component<Transform>* t, Component<Velocity>* v)
+	 * {
+	 *     t->position += v->velocity * dt;
+	 * });
+	 * \endcode
+	 *
+	 * \sa Component<T>::ForEach(F&&)
+	 */
+	template <typename... Ts>
+	class View
+	{
+		VLK_STATIC_ASSERT_MSG(sizeof...(Ts) > 0, "A view must contain at least one component type.");
+		VLK_STATIC_ASSERT_MSG(AllDistinct<Ts...>::value, "A view cannot contain the same component type more than once.");
+
+		static VLK_CXX14_CONSTEXPR Size TypeCount = sizeof...(Ts);
+
+		template <Size I>
+		using DataType = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+		public:
+		//! The components visited for a single entity, in the order of <tt>Ts...</tt>.
+		typedef std::tuple<Component<Ts>*...> TupleType;
+
+		private:
+		// Locks every type's mutex, ordered by address so that views of the same types in a different order cannot deadlock.
+		// std::less is used as, unlike <, it gives pointers to unrelated objects a total order.
+		template <typename L>
+		static std::array<L, TypeCount> LockAll()
+		{
+			std::array<VLK_SHARED_MUTEX_TYPE*, TypeCount> mutexes = {{ &Component<Ts>::s_mtx... }};
+			std::sort(mutexes.begin(), mutexes.end(), std::less<VLK_SHARED_MUTEX_TYPE*>());
+
+			std::array<L, TypeCount> locks;
+
+			for (Size i = 0; i < TypeCount; i++)
+			{
+				locks[i] = L(*mutexes[i]);
+			}
+
+			return locks;
+		}
+
+		// Returns the index in Ts of the type with the fewest components.
+		// Every type must be locked by the caller.
+		template <Size... I>
+		static Size Smallest(std::index_sequence<I...>)
+		{
+			std::array<Size, TypeCount> counts = {{ Component<DataType<I>>::CountUnlocked()... }};
+			return static_cast<Size>(std::min_element(counts.begin(), counts.end()) - counts.begin());
+		}
+
+		// The component driving the iteration is already known
+		template <Size I, typename P>
+		static inline P Find(P c, EntityID, std::true_type)
+		{
+			return c;
+		}
+
+		template <Size I, typename P>
+		static inline Component<DataType<I>>* Find(P, EntityID eId, std::false_type)
+		{
+			return EntityIndex<Component<DataType<I>>>::LookupOneUnlocked(eId);
+		}
+
+		// Visits every component of type D, and calls func for each entity that also has the other types.
+		// Every type must be locked by the caller.
+		template <Size D, typename F, Size... I>
+		static void Drive(F& func, std::index_sequence<I...>)
+		{
+			typedef Component<DataType<D>> DriverType;
+
+			for (auto it = DriverType::s_chunks.begin(); it != DriverType::s_chunks.end(); it++)
+			{
+				typename DriverType::ChunkType* ch = *it;
+
+				ch->ForEachOccupied([&func, ch](Size s)
+				{
+					DriverType* c = ch->At(s);
+					EntityID eId = c->GetEntity();
+					TupleType found(Find<I>(c, eId, std::integral_constant<bool, I == D>())...);
+
+					bool all = true;
+					int expand[] = { 0, (all &= (std::get<I>(found) != nullptr), 0)... };
+					(void)expand;
+
+					if (all) func(std::get<I>(found)...);
+				});
+			}
+		}
+
+		// Drives the iteration from the type at index d.
+		template <typename F, Size... I>
+		static void DriveFrom(Size d, F& func, std::index_sequence<I...> seq)
+		{
+			int expand[] = { 0, ((d == I) ? (Drive<I>(func, seq), 0) : 0)... };
+			(void)expand;
+		}
+
+		public:
+		/*!
+		 * \brief Performs a mutating function on every entity that has a component of each type.
+		 *
+		 * \param func A function object that can be called with one pointer to a Component of each type in <tt>Ts...</tt>, in order.
+		 * <tt>func</tt> must not call any function that locks any of the component types in this view.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Unique access to Component<T> for every T in <tt>Ts...</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa CForEach(F&&)
+		 */
+		template <typename F>
+		static void ForEach(F&& func)
+		{
+			auto locks = LockAll<std::unique_lock<VLK_SHARED_MUTEX_TYPE>>();
+			(void)locks;
+
+			DriveFrom(Smallest(std::index_sequence_for<Ts...>()), func, std::index_sequence_for<Ts...>());
+		}
+
+		/*!
+		 * \brief Performs a non-mutating function on every entity that has a component of each type.
+		 *
+		 * \param func A function object that can be called with one pointer to a const Component of each type in <tt>Ts...</tt>, in order.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to Component<T> for every T in <tt>Ts...</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa ForEach(F&&)
+		 */
+		template <typename F>
+		static void CForEach(F&& func)
+		{
+			auto locks = LockAll<std::shared_lock<VLK_SHARED_MUTEX_TYPE>>();
+			(void)locks;
+
+			auto constFunc = [&func](Component<Ts>*... cs) { func(static_cast<const Component<Ts>*>(cs)...); };
+			DriveFrom(Smallest(std::index_sequence_for<Ts...>()), constFunc, std::index_sequence_for<Ts...>());
+		}
+
+		/*!
+		 * \brief Returns the signature containing every type in <tt>Ts...</tt>.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * This function may block the calling thread the first time each type is used.<br>
+		 *
+		 * \sa Matches(EntityID)
+		 */
+		static ComponentSignature Signature()
+		{
+			ComponentSignature signature;
+			int expand[] = { 0, (signature.Set(Component<Ts>::TypeID()), 0)... };
+			(void)expand;
+			return signature;
+		}
+
+		/*!
+		 * \brief Returns true if an entity has at least one component of each type in <tt>Ts...</tt>.
+		 *
+		 * This compares the entity's signature against Signature() without looking up any components.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to the EntitySignatures shard containing <tt>eId</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa Component<T>::Has(EntityID)
+		 */
+		static bool Matches(EntityID eId)
+		{
+			static const ComponentSignature required = Signature();
+			return EntitySignatures::Get(eId).Contains(required);
+		}
+
+		/*!
+		 * \brief Finds every entity that has a component of each type.
+		 *
+		 * \param vecOut A vector to write one tuple of components to for each entity found.
+		 * Existing contents are not modified, but the vector may be resized.
+		 *
+		 * \return The number of tuples appended to vecOut.
+		 *
+		 * \ts
+		 * May be called from any thread.<br>
+		 * Resource locking is handled internally.<br>
+		 * Shared access to Component<T> for every T in <tt>Ts...</tt> is required.<br>
+		 * This function may block the calling thread.<br>
+		 *
+		 * \sa ForEach(F&&)
+		 */
+		static Size Collect(std::vector<TupleType>& vecOut)
+		{
+			auto locks = LockAll<std::shared_lock<VLK_SHARED_MUTEX_TYPE>>();
+			(void)locks;
+
+			Size before = vecOut.size();
+			auto append = [&vecOut](Component<Ts>*... cs) { vecOut.emplace_back(cs...); };
+			DriveFrom(Smallest(std::index_sequence_for<Ts...>()), append, std::index_sequence_for<Ts...>());
+
+			return vecOut.size() - before;
+		}
+	};
+
+	template <typename... Ts>
+	VLK_CXX14_CONSTEXPR Size View<Ts...>::TypeCount;
+}
+
+#endif
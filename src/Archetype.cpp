@@ -0,0 +1,337 @@
+#include "ValkyrieEngine/Archetype.hpp"
+#include "ValkyrieEngine/Util.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+
+using namespace vlk;
+
+namespace
+{
+	// Where an entity's data is stored
+	struct Record
+	{
+		Archetype* archetype;
+		Size row;
+	};
+
+	VLK_SHARED_MUTEX_TYPE mtx;
+	std::map<std::vector<Size>, std::unique_ptr<Archetype>> archetypes;
+	std::unordered_map<EntityID, Record> records;
+
+	// Rounds v up to a multiple of 64
+	inline Size AlignUp(Size v)
+	{
+		return (v + 63) & ~static_cast<Size>(63);
+	}
+
+	bool TypeLess(const ArchetypeTypeInfo* a, const ArchetypeTypeInfo* b)
+	{
+		return a->id < b->id;
+	}
+
+	// Points the record of an entity moved by Archetype::Remove at its new row
+	inline void UpdateMoved(EntityID moved, EntityID removed, Size row)
+	{
+		if (moved != removed) records[moved].row = row;
+	}
+}
+
+VLK_CXX14_CONSTEXPR Size Archetype::ChunkBytes;
+
+Archetype::Archetype(const std::vector<const ArchetypeTypeInfo*>& _types) :
+	types(_types),
+	offsets(_types.size()),
+	capacity(0),
+	count(0)
+{
+	// Every column starts on a cache line, so each costs up to 63 bytes of padding
+	Size rowBytes = sizeof(EntityID);
+	Size padding = 64 * types.size();
+
+	for (auto it = types.begin(); it != types.end(); it++)
+	{
+		rowBytes += (*it)->size;
+	}
+
+	capacity = (ChunkBytes > padding + rowBytes) ? (ChunkBytes - padding) / rowBytes : 1;
+
+	Size offset = AlignUp(sizeof(EntityID) * capacity);
+
+	for (Size i = 0; i < types.size(); i++)
+	{
+		offsets[i] = offset;
+		offset = AlignUp(offset + types[i]->size * capacity);
+	}
+}
+
+Archetype::~Archetype()
+{
+	for (Size row = 0; row < count; row++)
+	{
+		for (Size i = 0; i < types.size(); i++)
+		{
+			types[i]->destroy(At(i, row));
+		}
+	}
+
+	for (auto it = chunks.begin(); it != chunks.end(); it++)
+	{
+		AlignedFree(*it);
+	}
+}
+
+Size Archetype::ColumnOf(Size typeId) const
+{
+	Size first = 0;
+	Size last = types.size();
+
+	while (first < last)
+	{
+		Size mid = (first + last) / 2;
+
+		if (types[mid]->id < typeId) first = mid + 1;
+		else last = mid;
+	}
+
+	return ((first < types.size()) && (types[first]->id == typeId)) ? first : types.size();
+}
+
+Size Archetype::Push(EntityID eId)
+{
+	if (count == chunks.size() * capacity)
+	{
+		Size bytes = types.empty() ? ChunkBytes : std::max(ChunkBytes, offsets.back() + types.back()->size * capacity);
+		void* chunk = AlignedAlloc(64, bytes);
+		if (chunk == nullptr) throw std::bad_alloc();
+		chunks.push_back(static_cast<UByte*>(chunk));
+	}
+
+	Size row = count++;
+	Entities(row / capacity)[row % capacity] = eId;
+	return row;
+}
+
+EntityID Archetype::Remove(Size row)
+{
+	Size last = --count;
+	EntityID moved = EntityAt(last);
+
+	if (row != last)
+	{
+		for (Size i = 0; i < types.size(); i++)
+		{
+			types[i]->relocate(At(i, row), At(i, last));
+		}
+
+		Entities(row / capacity)[row % capacity] = moved;
+	}
+
+	// Keep one spare chunk so an entity moving back and forth across a chunk boundary doesn't allocate each time
+	if (chunks.size() > ChunkCount() + 1)
+	{
+		AlignedFree(chunks.back());
+		chunks.pop_back();
+	}
+
+	return moved;
+}
+
+Archetype* ArchetypeStorage::FindArchetype(const std::vector<const ArchetypeTypeInfo*>& types)
+{
+	std::vector<Size> key(types.size());
+
+	for (Size i = 0; i < types.size(); i++)
+	{
+		key[i] = types[i]->id;
+	}
+
+	std::unique_ptr<Archetype>& found = archetypes[key];
+	if (!found) found.reset(new Archetype(types));
+	return found.get();
+}
+
+Archetype* ArchetypeStorage::WithType(Archetype* from, const ArchetypeTypeInfo& type)
+{
+	if (from == nullptr) return FindArchetype({ &type });
+
+	auto edge = from->addEdges.find(type.id);
+	if (edge != from->addEdges.end()) return edge->second;
+
+	std::vector<const ArchetypeTypeInfo*> types(from->types);
+	types.insert(std::upper_bound(types.begin(), types.end(), &type, TypeLess), &type);
+
+	Archetype* to = FindArchetype(types);
+	from->addEdges[type.id] = to;
+	to->removeEdges[type.id] = from;
+	return to;
+}
+
+Archetype* ArchetypeStorage::WithoutType(Archetype* from, const ArchetypeTypeInfo& type)
+{
+	auto edge = from->removeEdges.find(type.id);
+	if (edge != from->removeEdges.end()) return edge->second;
+
+	std::vector<const ArchetypeTypeInfo*> types(from->types);
+	types.erase(types.begin() + from->ColumnOf(type.id));
+
+	Archetype* to = types.empty() ? nullptr : FindArchetype(types);
+	from->removeEdges[type.id] = to;
+	if (to != nullptr) to->addEdges[type.id] = from;
+	return to;
+}
+
+void* ArchetypeStorage::AttachErased(EntityID eId, const ArchetypeTypeInfo& type, ConstructFunc construct, void* args)
+{
+	std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+	auto it = records.find(eId);
+	Archetype* from = (it == records.end()) ? nullptr : it->second.archetype;
+
+	if ((from != nullptr) && (from->ColumnOf(type.id) != from->types.size()))
+	{
+		throw std::logic_error("Entity already has an instance of this type in archetype storage.");
+	}
+
+	Archetype* to = WithType(from, type);
+	Size row = to->Push(eId);
+	Size column = to->ColumnOf(type.id);
+
+	try
+	{
+		construct(to->At(column, row), args);
+	}
+	catch (...)
+	{
+		to->Remove(row);
+		throw;
+	}
+
+	if (from == nullptr)
+	{
+		records.emplace(eId, Record { to, row });
+	}
+	else
+	{
+		Size oldRow = it->second.row;
+
+		for (Size i = 0; i < from->types.size(); i++)
+		{
+			from->types[i]->relocate(to->At(to->ColumnOf(from->types[i]->id), row), from->At(i, oldRow));
+		}
+
+		it->second = Record { to, row };
+		UpdateMoved(from->Remove(oldRow), eId, oldRow);
+	}
+
+	return to->At(column, row);
+}
+
+bool ArchetypeStorage::DetachErased(EntityID eId, const ArchetypeTypeInfo& type)
+{
+	std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+	auto it = records.find(eId);
+	if (it == records.end()) return false;
+
+	Archetype* from = it->second.archetype;
+	Size oldRow = it->second.row;
+	Size column = from->ColumnOf(type.id);
+	if (column == from->types.size()) return false;
+
+	Archetype* to = WithoutType(from, type);
+	from->types[column]->destroy(from->At(column, oldRow));
+
+	if (to == nullptr)
+	{
+		records.erase(it);
+	}
+	else
+	{
+		Size row = to->Push(eId);
+
+		for (Size i = 0; i < from->types.size(); i++)
+		{
+			if (i != column) from->types[i]->relocate(to->At(to->ColumnOf(from->types[i]->id), row), from->At(i, oldRow));
+		}
+
+		it->second = Record { to, row };
+	}
+
+	UpdateMoved(from->Remove(oldRow), eId, oldRow);
+	return true;
+}
+
+void* ArchetypeStorage::GetErased(EntityID eId, const ArchetypeTypeInfo& type)
+{
+	std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
+
+	auto it = records.find(eId);
+	if (it == records.end()) return nullptr;
+
+	Archetype* a = it->second.archetype;
+	Size column = a->ColumnOf(type.id);
+	return (column == a->types.size()) ? nullptr : a->At(column, it->second.row);
+}
+
+void ArchetypeStorage::VisitMatching(const ArchetypeTypeInfo* const* types, Size n, bool exclusive, VisitFunc visit, void* context)
+{
+	std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx, std::defer_lock);
+	std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx, std::defer_lock);
+
+	if (exclusive) ulock.lock();
+	else slock.lock();
+
+	std::vector<Size> columns(n);
+
+	for (auto it = archetypes.begin(); it != archetypes.end(); it++)
+	{
+		Archetype* a = it->second.get();
+		if (a->count == 0) continue;
+
+		bool matches = true;
+
+		for (Size i = 0; (i < n) & matches; i++)
+		{
+			columns[i] = a->ColumnOf(types[i]->id);
+			matches = columns[i] != a->types.size();
+		}
+
+		if (matches) visit(*a, columns.data(), context);
+	}
+}
+
+void ArchetypeStorage::Delete(EntityID eId)
+{
+	std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(mtx);
+
+	auto it = records.find(eId);
+	if (it == records.end()) return;
+
+	Archetype* from = it->second.archetype;
+	Size oldRow = it->second.row;
+
+	for (Size i = 0; i < from->types.size(); i++)
+	{
+		from->types[i]->destroy(from->At(i, oldRow));
+	}
+
+	records.erase(it);
+	UpdateMoved(from->Remove(oldRow), eId, oldRow);
+}
+
+Size ArchetypeStorage::EntityCount()
+{
+	std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
+	return records.size();
+}
+
+Size ArchetypeStorage::ArchetypeCount()
+{
+	std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(mtx);
+	return archetypes.size();
+}
@@ -0,0 +1,44 @@
+#include "ValkyrieEngine/ChunkAllocator.hpp"
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+using namespace vlk;
+
+void* VirtualMemory::Reserve(Size size)
+{
+	#if defined(_WIN32)
+		return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+	#else
+		void* p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return (p == MAP_FAILED) ? nullptr : p;
+	#endif
+}
+
+bool VirtualMemory::Commit(void* p, Size size)
+{
+	#if defined(_WIN32)
+		return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	#else
+		return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+	#endif
+}
+
+void VirtualMemory::AdviseHugePages(void* p, Size size)
+{
+	#if defined(MADV_HUGEPAGE)
+		madvise(p, size, MADV_HUGEPAGE);
+	#else
+		(void)p;
+		(void)size;
+	#endif
+}
@@ -1,7 +1,7 @@
 #include "ValkyrieEngine/Entity.hpp"
-#include <unordered_map>
+#include "ValkyrieEngine/Archetype.hpp"
+#include "ValkyrieEngine/Signature.hpp"
 #include <mutex>
-#include <vector>
 
 using namespace vlk;
 
@@ -22,14 +22,14 @@ EntityID Entity::Create()
 void Entity::Delete(EntityID id)
 {
 	std::unique_lock<std::mutex> ulock(mtx);
-	std::vector<IComponent*> toRemove;
 
-	ECRegistry<IComponent>::LookupAll(id, toRemove);
+	// Deleting components clears their bits from the signature, so iterate over a copy
+	ComponentSignature signature = EntitySignatures::Get(id);
 
-	// Components call Unregister in their Delete function,
-	// this would invalidate search iterators above and cause a resource deadlock.
-	for (auto it = toRemove.begin(); it != toRemove.end(); it++)
-	{// Delete component
-		(*it)->Delete();
-	}
+	signature.ForEach([id](Size typeId)
+	{
+		EntitySignatures::TypeAt(typeId)->deleteAttached(id);
+	});
+
+	ArchetypeStorage::Delete(id);
 }
@@ -0,0 +1,138 @@
+#include "ValkyrieEngine/Epoch.hpp"
+#include "ValkyrieEngine/Util.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace vlk;
+
+namespace
+{
+	// The epoch a thread is reading in, aligned to a cache line so that threads entering guards don't contend
+	struct alignas(64) Record
+	{
+		std::atomic<ULong> epoch { 0 }; // 0 if the thread is not inside a guard
+		std::atomic<bool> inUse { true };
+		Record* next = nullptr;
+	};
+
+	struct Retired
+	{
+		void* p;
+		Epoch::DeleteFunc deleter;
+		ULong epoch;
+	};
+
+	// Starts at 1 so that 0 can mean a thread is not reading
+	std::atomic<ULong> globalEpoch { 1 };
+
+	// Records are never freed, a thread that exits leaves its record for the next new thread to reuse
+	std::atomic<Record*> records { nullptr };
+
+	std::mutex retireMtx;
+	std::vector<Retired> retired;
+
+	Record* AcquireRecord()
+	{
+		for (Record* r = records.load(); r != nullptr; r = r->next)
+		{
+			bool expected = false;
+			if (r->inUse.compare_exchange_strong(expected, true)) return r;
+		}
+
+		// Allocated with AlignedAlloc as new does not respect the alignment of Record before C++17
+		void* mem = AlignedAlloc(alignof(Record), sizeof(Record));
+		if (mem == nullptr) throw std::bad_alloc();
+
+		Record* r = new (mem) Record();
+		r->next = records.load();
+		while (!records.compare_exchange_weak(r->next, r)) { }
+		return r;
+	}
+
+	struct ThreadState
+	{
+		Record* record = nullptr;
+		Size depth = 0;
+
+		~ThreadState()
+		{
+			if (record != nullptr) record->inUse.store(false);
+		}
+	};
+
+	thread_local ThreadState threadState;
+
+	// Moves to the next epoch if every thread inside a guard has seen the current one.
+	// Returns the current epoch.
+	ULong TryAdvance()
+	{
+		ULong current = globalEpoch.load();
+
+		for (Record* r = records.load(); r != nullptr; r = r->next)
+		{
+			ULong e = r->epoch.load();
+			if ((e != 0) && (e != current)) return current;
+		}
+
+		globalEpoch.compare_exchange_strong(current, current + 1);
+		return globalEpoch.load();
+	}
+
+	// retireMtx must be locked by the caller
+	Size ReclaimLocked()
+	{
+		ULong current = TryAdvance();
+
+		// Readers that could see memory retired in epoch e have all left once the epoch has moved on twice
+		auto keep = retired.begin();
+
+		for (auto it = retired.begin(); it != retired.end(); it++)
+		{
+			if (it->epoch + 2 <= current) it->deleter(it->p);
+			else *keep++ = *it;
+		}
+
+		retired.erase(keep, retired.end());
+		return retired.size();
+	}
+}
+
+Epoch::Guard::Guard()
+{
+	ThreadState& state = threadState;
+	if (state.depth++ != 0) return;
+
+	if (state.record == nullptr) state.record = AcquireRecord();
+
+	// Sequentially consistent, so the epoch is published before any shared memory is read
+	state.record->epoch.store(globalEpoch.load());
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+Epoch::Guard::~Guard()
+{
+	ThreadState& state = threadState;
+	if (--state.depth != 0) return;
+
+	state.record->epoch.store(0, std::memory_order_release);
+}
+
+void Epoch::Retire(void* p, DeleteFunc deleter)
+{
+	// The memory must be unlinked before the epochs of readers are checked
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	std::unique_lock<std::mutex> ulock(retireMtx);
+
+	retired.push_back(Retired { p, deleter, globalEpoch.load() });
+	ReclaimLocked();
+}
+
+Size Epoch::Reclaim()
+{
+	std::unique_lock<std::mutex> ulock(retireMtx);
+	return ReclaimLocked();
+}
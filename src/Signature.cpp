@@ -0,0 +1,172 @@
+#include "ValkyrieEngine/Signature.hpp"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace vlk;
+
+namespace
+{
+	const Size ShardBits = 4;
+	const Size ShardCount = Size(1) << ShardBits;
+	const Size PageBits = 10;
+	const Size PageSize = Size(1) << PageBits;
+
+	struct Page
+	{
+		ComponentSignature signatures[PageSize];
+		Size live = 0; // Number of non-empty signatures
+	};
+
+	// Aligned to a cache line so that locking one shard does not contend with its neighbours
+	struct alignas(64) Shard
+	{
+		VLK_SHARED_MUTEX_TYPE mtx;
+		std::vector<std::unique_ptr<Page>> pages;
+	};
+
+	Shard shards[ShardCount];
+
+	std::mutex typeMtx;
+	std::array<const ComponentTypeInfo*, ComponentSignature::Capacity> types;
+	Size typeCount = 0;
+
+	inline Shard& ShardOf(EntityID entity)
+	{
+		return shards[entity & (ShardCount - 1)];
+	}
+
+	inline Size PageOf(EntityID entity)
+	{
+		return static_cast<Size>(entity >> (ShardBits + PageBits));
+	}
+
+	inline Size SlotOf(EntityID entity)
+	{
+		return static_cast<Size>(entity >> ShardBits) & (PageSize - 1);
+	}
+
+	// Returns the signature of an entity, or nullptr if its page does not exist.
+	// The shard must be locked by the caller.
+	inline const ComponentSignature* Find(Shard& shard, EntityID entity)
+	{
+		Size page = PageOf(entity);
+		if ((page >= shard.pages.size()) || !shard.pages[page]) return nullptr;
+		return &shard.pages[page]->signatures[SlotOf(entity)];
+	}
+
+	// The shard must be uniquely locked by the caller
+	void SetLocked(Shard& shard, EntityID entity, Size typeId)
+	{
+		Size page = PageOf(entity);
+		if (page >= shard.pages.size()) shard.pages.resize(page + 1);
+		if (!shard.pages[page]) shard.pages[page].reset(new Page());
+
+		Page& p = *shard.pages[page];
+		ComponentSignature& signature = p.signatures[SlotOf(entity)];
+
+		if (signature.Empty()) p.live++;
+		signature.Set(typeId);
+	}
+
+	// The shard must be uniquely locked by the caller
+	void ResetLocked(Shard& shard, EntityID entity, Size typeId)
+	{
+		Size page = PageOf(entity);
+		if ((page >= shard.pages.size()) || !shard.pages[page]) return;
+
+		Page& p = *shard.pages[page];
+		ComponentSignature& signature = p.signatures[SlotOf(entity)];
+		if (!signature.Test(typeId)) return;
+
+		signature.Reset(typeId);
+		if (signature.Empty() && (--p.live == 0)) shard.pages[page].reset();
+	}
+}
+
+VLK_CXX14_CONSTEXPR Size ComponentSignature::Capacity;
+VLK_CXX14_CONSTEXPR Size ComponentSignature::WordCount;
+
+Size EntitySignatures::RegisterType(const ComponentTypeInfo* info)
+{
+	std::unique_lock<std::mutex> ulock(typeMtx);
+
+	if (typeCount == ComponentSignature::Capacity)
+	{
+		throw std::length_error("Too many component types, increase VLK_MAX_COMPONENT_TYPES.");
+	}
+
+	types[typeCount] = info;
+	return typeCount++;
+}
+
+const ComponentTypeInfo* EntitySignatures::TypeAt(Size typeId)
+{
+	return types[typeId];
+}
+
+void EntitySignatures::Set(EntityID entity, Size typeId)
+{
+	Shard& shard = ShardOf(entity);
+	std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shard.mtx);
+	SetLocked(shard, entity, typeId);
+}
+
+void EntitySignatures::SetMany(const EntityID* entities, Size n, Size typeId)
+{
+	for (Size s = 0; s < ShardCount; s++)
+	{
+		std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shards[s].mtx, std::defer_lock);
+
+		for (Size i = 0; i < n; i++)
+		{
+			if ((entities[i] & (ShardCount - 1)) != s) continue;
+			if (!ulock.owns_lock()) ulock.lock();
+			SetLocked(shards[s], entities[i], typeId);
+		}
+	}
+}
+
+void EntitySignatures::Reset(EntityID entity, Size typeId)
+{
+	Shard& shard = ShardOf(entity);
+	std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shard.mtx);
+	ResetLocked(shard, entity, typeId);
+}
+
+void EntitySignatures::ResetMany(const EntityID* entities, Size n, Size typeId)
+{
+	for (Size s = 0; s < ShardCount; s++)
+	{
+		std::unique_lock<VLK_SHARED_MUTEX_TYPE> ulock(shards[s].mtx, std::defer_lock);
+
+		for (Size i = 0; i < n; i++)
+		{
+			if ((entities[i] & (ShardCount - 1)) != s) continue;
+			if (!ulock.owns_lock()) ulock.lock();
+			ResetLocked(shards[s], entities[i], typeId);
+		}
+	}
+}
+
+bool EntitySignatures::Test(EntityID entity, Size typeId)
+{
+	Shard& shard = ShardOf(entity);
+	std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(shard.mtx);
+
+	const ComponentSignature* signature = Find(shard, entity);
+	return (signature != nullptr) && signature->Test(typeId);
+}
+
+ComponentSignature EntitySignatures::Get(EntityID entity)
+{
+	Shard& shard = ShardOf(entity);
+	std::shared_lock<VLK_SHARED_MUTEX_TYPE> slock(shard.mtx);
+
+	const ComponentSignature* signature = Find(shard, entity);
+	return (signature == nullptr) ? ComponentSignature() : *signature;
+}
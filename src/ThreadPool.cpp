@@ -0,0 +1,119 @@
+#include "ValkyrieEngine/ThreadPool.hpp"
+
+#include <algorithm>
+
+using namespace vlk;
+
+ThreadPool::ThreadPool(Size numWorkers) :
+	stopping(false)
+{
+	workers.reserve(numWorkers);
+
+	for (Size i = 0; i < numWorkers; i++)
+	{
+		workers.emplace_back(&ThreadPool::WorkerMain, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> ulock(mtx);
+		stopping = true;
+	}
+
+	wake.notify_all();
+
+	for (auto it = workers.begin(); it != workers.end(); it++)
+	{
+		it->join();
+	}
+}
+
+ThreadPool& ThreadPool::Global()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+	return pool;
+}
+
+void ThreadPool::RunJob(Job* job)
+{
+	for (Size i = job->next++; i < job->count; i = job->next++)
+	{
+		try
+		{
+			(*job->func)(i);
+		}
+		catch (...)
+		{
+			std::unique_lock<std::mutex> ulock(job->errorMtx);
+			if (!job->error) job->error = std::current_exception();
+
+			// Skip any remaining work
+			job->next = job->count;
+		}
+	}
+}
+
+void ThreadPool::WorkerMain()
+{
+	std::unique_lock<std::mutex> ulock(mtx);
+
+	while (true)
+	{
+		wake.wait(ulock, [this]() { return stopping | !queue.empty(); });
+
+		if (queue.empty()) return;
+
+		Job* job = queue.front();
+		queue.pop_front();
+
+		ulock.unlock();
+		RunJob(job);
+		ulock.lock();
+
+		// Decrement under the lock so the owner can't miss the notification
+		if (--job->pendingHelpers == 0) done.notify_all();
+	}
+}
+
+void ThreadPool::ParallelFor(Size count, const std::function<void(Size)>& func)
+{
+	if (count == 0) return;
+
+	Job job;
+	job.func = &func;
+	job.count = count;
+	job.next = 0;
+
+	// No point waking more helpers than there are indices for
+	Size numHelpers = std::min(workers.size(), count - 1);
+	job.pendingHelpers = numHelpers;
+
+	if (numHelpers > 0)
+	{
+		{
+			std::unique_lock<std::mutex> ulock(mtx);
+			queue.insert(queue.end(), numHelpers, &job);
+		}
+
+		wake.notify_all();
+	}
+
+	RunJob(&job);
+
+	{// Wait only for helpers already running this job.
+		// Running other callers' jobs here could re-enter locks the caller holds, such as Component<T>::s_mtx.
+		std::unique_lock<std::mutex> ulock(mtx);
+
+		// Every index has been claimed, so helpers no worker has picked up yet would have nothing to do.
+		// Withdrawing them means this never waits on queued work, which keeps nested calls from deadlocking.
+		auto unclaimed = std::remove(queue.begin(), queue.end(), &job);
+		job.pendingHelpers -= static_cast<Size>(queue.end() - unclaimed);
+		queue.erase(unclaimed, queue.end());
+
+		done.wait(ulock, [&job]() { return job.pendingHelpers == 0; });
+	}
+
+	if (job.error) std::rethrow_exception(job.error);
+}
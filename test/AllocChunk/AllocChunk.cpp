@@ -2,6 +2,7 @@
 #include "catch2/catch.hpp"
 
 #include <set>
+#include <vector>
 
 using namespace vlk;
 
@@ -129,3 +130,143 @@ TEST_CASE("Allocator owns its pointers")
 	b = reinterpret_cast<Byte*>(alloc.At(AllocType::ChunkSize - 1));
 	REQUIRE(!alloc.OwnsPointer(reinterpret_cast<AllocType::PointerType>(b + 1)));
 }
+
+TEST_CASE("AllocChunk spanning multiple occupation words")
+{
+	typedef AllocChunk<AllocData, 130> WideType;
+	WideType alloc;
+
+	for (Size s = 0; s < WideType::ChunkSize; s++)
+	{
+		REQUIRE(alloc.Allocate() == alloc.At(s));
+		REQUIRE(alloc.Count() == s + 1);
+	}
+
+	REQUIRE(alloc.Full());
+	REQUIRE_THROWS_AS((void)alloc.Allocate(), std::bad_alloc);
+
+	alloc.Deallocate(alloc.At(129));
+	alloc.Deallocate(alloc.At(64));
+	alloc.Deallocate(alloc.At(3));
+
+	REQUIRE(!alloc.Full());
+	REQUIRE(alloc.Count() == WideType::ChunkSize - 3);
+
+	// Freed spaces are reused lowest-first
+	REQUIRE(alloc.Allocate() == alloc.At(3));
+	REQUIRE(alloc.Allocate() == alloc.At(64));
+	REQUIRE(alloc.Allocate() == alloc.At(129));
+	REQUIRE(alloc.Full());
+
+	for (Size s = 0; s < WideType::ChunkSize; s++)
+	{
+		alloc.Deallocate(alloc.At(s));
+	}
+
+	REQUIRE(alloc.Empty());
+	REQUIRE(alloc.Count() == 0);
+}
+
+TEST_CASE("AllocChunk finds the owner of its pointers")
+{
+	AllocType* a = AllocType::Create();
+	AllocType* b = AllocType::Create();
+
+	REQUIRE(reinterpret_cast<std::uintptr_t>(a) % AllocType::Alignment() == 0);
+	REQUIRE(reinterpret_cast<std::uintptr_t>(b) % AllocType::Alignment() == 0);
+
+	for (Size s = 0; s < AllocType::ChunkSize; s++)
+	{
+		REQUIRE(AllocType::FromPointer(a->At(s)) == a);
+		REQUIRE(AllocType::FromPointer(b->At(s)) == b);
+		REQUIRE(a->IndexOf(a->At(s)) == s);
+	}
+
+	AllocType::Destroy(a);
+	AllocType::Destroy(b);
+}
+
+TEST_CASE("AllocChunk iterates occupied spaces")
+{
+	typedef AllocChunk<AllocData, 200> WideType;
+	WideType alloc;
+
+	for (Size s = 0; s < WideType::ChunkSize; s++)
+	{
+		(void)alloc.Allocate();
+	}
+
+	// Leave the first word dense, and the rest sparse
+	for (Size s = 64; s < WideType::ChunkSize; s++)
+	{
+		if (s % 7 != 0) alloc.Deallocate(alloc.At(s));
+	}
+
+	std::vector<Size> expected;
+
+	for (Size s = 0; s < WideType::ChunkSize; s++)
+	{
+		if (alloc.IsOccupied(s)) expected.push_back(s);
+	}
+
+	std::vector<Size> iterated;
+
+	for (Size i : alloc.Occupied())
+	{
+		iterated.push_back(i);
+	}
+
+	std::vector<Size> visited;
+	alloc.ForEachOccupied([&visited](Size i) { visited.push_back(i); });
+
+	REQUIRE(iterated == expected);
+	REQUIRE(visited == expected);
+
+	WideType empty;
+	REQUIRE(empty.Occupied().begin() == empty.Occupied().end());
+}
+
+TEST_CASE("AllocChunk can be backed by a reserved region")
+{
+	typedef AllocChunk<AllocData, 32, NoChunkColumns, MappedChunkAllocator<AllocData, 1024 * 1024>> MappedType;
+	typedef MappedType::AllocatorType RegionType;
+
+	MappedType* a = MappedType::Create();
+	MappedType* b = MappedType::Create();
+
+	REQUIRE(RegionType::Contains(a));
+	REQUIRE(RegionType::Contains(b));
+	REQUIRE(reinterpret_cast<std::uintptr_t>(a) % MappedType::Alignment() == 0);
+
+	// Chunks are committed one after another
+	REQUIRE(reinterpret_cast<std::uintptr_t>(b) - reinterpret_cast<std::uintptr_t>(a) == MappedType::Alignment());
+
+	AllocData* d = b->Allocate();
+	new (d) AllocData();
+	REQUIRE(MappedType::FromPointer(d) == b);
+	d->~AllocData();
+	b->Deallocate(d);
+
+	// Freed chunks are reused before more of the region is committed
+	MappedType::Destroy(b);
+	MappedType* c = MappedType::Create();
+	REQUIRE(c == b);
+
+	// Chunks that don't fit in the region come from the heap
+	std::vector<MappedType*> chunks;
+
+	for (Size s = 0; s < 1024 * 1024 / MappedType::Alignment() + 1; s++)
+	{
+		chunks.push_back(MappedType::Create());
+	}
+
+	REQUIRE(!RegionType::Contains(chunks.back()));
+
+	for (MappedType* ch : chunks)
+	{
+		MappedType::Destroy(ch);
+	}
+
+	MappedType::Destroy(a);
+	MappedType::Destroy(c);
+}
@@ -0,0 +1,72 @@
+#include "ValkyrieEngine/Component.hpp"
+#include "ValkyrieEngine/Entity.hpp"
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace vlk;
+
+// Benchmarks are hidden by default, run them with the "[benchmark]" tag.
+
+namespace
+{
+	struct BenchData
+	{
+		Float x = 0.0f;
+		Float y = 0.0f;
+		Float z = 0.0f;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	Double NanosecondsPer(Clock::duration d, Size n)
+	{
+		return std::chrono::duration<Double, std::nano>(d).count() / static_cast<Double>(n);
+	}
+}
+
+TEST_CASE("Component create and delete cost is independent of pool size", "[.][benchmark]")
+{
+	const Size batchSize = 100000;
+	const Size numBatches = 10;
+
+	std::vector<EntityID> entities;
+	std::vector<Component<BenchData>*> components;
+	entities.reserve(batchSize * numBatches);
+	components.reserve(batchSize * numBatches);
+
+	for (Size i = 0; i < batchSize * numBatches; i++)
+	{
+		entities.push_back(Entity::Create());
+	}
+
+	for (Size b = 0; b < numBatches; b++)
+	{
+		auto start = Clock::now();
+
+		for (Size i = b * batchSize; i < (b + 1) * batchSize; i++)
+		{
+			components.push_back(Component<BenchData>::Create(entities[i]));
+		}
+
+		WARN("Create batch " << b << ": " << NanosecondsPer(Clock::now() - start, batchSize) << " ns/component");
+	}
+
+	REQUIRE(Component<BenchData>::Count() == batchSize * numBatches);
+
+	for (Size b = 0; b < numBatches; b++)
+	{
+		auto start = Clock::now();
+
+		for (Size i = b * batchSize; i < (b + 1) * batchSize; i++)
+		{
+			components[i]->Delete();
+		}
+
+		WARN("Delete batch " << b << ": " << NanosecondsPer(Clock::now() - start, batchSize) << " ns/component");
+	}
+
+	REQUIRE(Component<BenchData>::Count() == 0);
+	REQUIRE(Component<BenchData>::ChunkCount() == 0);
+}
@@ -3,8 +3,11 @@
 #include "ValkyrieEngine/Entity.hpp"
 #include "catch2/catch.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <chrono>
+#include <string>
 
 using namespace vlk;
 
@@ -297,3 +300,1195 @@ TEST_CASE("Components are destructed properly")
 	REQUIRE(Component<Counter>::Count() == 0);
 	REQUIRE(Component<Counter>::ChunkCount() == 0);
 }
+
+TEST_CASE("Empty chunks are retained for reuse")
+{
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+
+	Component<SampleComponent>::ShrinkToFit();
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 0);
+
+	EntityID eId = Entity::Create();
+	std::vector<Component<SampleComponent>*> components;
+
+	for (Size i = 0; i < Component<SampleComponent>::ChunkSize + 1; i++)
+	{
+		components.push_back(Component<SampleComponent>::Create(eId));
+	}
+
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 2);
+
+	// Oscillate across the chunk boundary
+	for (int i = 0; i < 10; i++)
+	{
+		components.back()->Delete();
+
+		REQUIRE(Component<SampleComponent>::ChunkCount() == 1);
+		REQUIRE(Component<SampleComponent>::SpareChunkCount() == 1);
+
+		components.back() = Component<SampleComponent>::Create(eId);
+
+		REQUIRE(Component<SampleComponent>::ChunkCount() == 2);
+		REQUIRE(Component<SampleComponent>::SpareChunkCount() == 0);
+	}
+
+	Entity::Delete(eId);
+
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == GetComponentHints<SampleComponent>().allocRetainedBlocks);
+
+	Component<SampleComponent>::ShrinkToFit();
+
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 0);
+}
+
+struct ReservedData
+{
+	Int i = 0;
+};
+
+template <>
+VLK_CXX14_CONSTEXPR inline ComponentHints vlk::GetComponentHints<ReservedData>()
+{
+	return ComponentHints { 16, true, 0, 40 };
+}
+
+TEST_CASE("Reserving components pre-allocates chunks")
+{
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 0);
+
+	Component<SampleComponent>::Reserve(200);
+
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 4);
+
+	EntityID eId = Entity::Create();
+
+	for (int i = 0; i < 200; i++)
+	{
+		(void)Component<SampleComponent>::Create(eId);
+	}
+
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 4);
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 0);
+
+	Entity::Delete(eId);
+
+	// Reserved chunks are kept when they become empty
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 4);
+
+	Component<SampleComponent>::ShrinkToFit();
+
+	REQUIRE(Component<SampleComponent>::SpareChunkCount() == 0);
+
+	REQUIRE_THROWS_AS(Component<OtherComponent>::Reserve(11), std::range_error);
+	Component<OtherComponent>::Reserve(10);
+	REQUIRE(Component<OtherComponent>::SpareChunkCount() == 1);
+	Component<OtherComponent>::ShrinkToFit();
+}
+
+TEST_CASE("Initial capacity hint reserves chunks on first use")
+{
+	REQUIRE(Component<ReservedData>::SpareChunkCount() == 0);
+
+	EntityID eId = Entity::Create();
+	(void)Component<ReservedData>::Create(eId);
+
+	REQUIRE(Component<ReservedData>::ChunkCount() == 1);
+	REQUIRE(Component<ReservedData>::SpareChunkCount() == 2);
+
+	Entity::Delete(eId);
+
+	REQUIRE(Component<ReservedData>::ChunkCount() == 0);
+	REQUIRE(Component<ReservedData>::SpareChunkCount() == 3);
+
+	Component<ReservedData>::ShrinkToFit();
+
+	REQUIRE(Component<ReservedData>::SpareChunkCount() == 0);
+}
+
+TEST_CASE("Components can be created and deleted in bulk")
+{
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+
+	std::vector<EntityID> ids;
+	std::vector<Component<SampleComponent>*> components(150);
+
+	for (int i = 0; i < 150; i++)
+	{
+		ids.push_back(Entity::Create());
+	}
+
+	Component<SampleComponent>::CreateMany(components.data(), ids.data(), ids.size());
+
+	REQUIRE(Component<SampleComponent>::Count() == 150);
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 3);
+
+	for (Size i = 0; i < ids.size(); i++)
+	{
+		REQUIRE(components[i]->GetEntity() == ids[i]);
+		REQUIRE(Component<SampleComponent>::FindOne(ids[i]) == components[i]);
+	}
+
+	Component<SampleComponent>::DeleteMany(components.data(), 100);
+
+	REQUIRE(Component<SampleComponent>::Count() == 50);
+	REQUIRE(Component<SampleComponent>::FindOne(ids[0]) == nullptr);
+	REQUIRE(Component<SampleComponent>::FindOne(ids[100]) == components[100]);
+
+	Component<SampleComponent>::DeleteMany(components.data() + 100, 50);
+
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+	REQUIRE(Component<SampleComponent>::ChunkCount() == 0);
+
+	Component<OtherComponent>::CreateMany(ids.data(), 5, 3.0);
+
+	REQUIRE(Component<OtherComponent>::Count() == 5);
+	REQUIRE(Component<OtherComponent>::FindOne(ids[4])->i == 3);
+
+	// Failure part way through leaves no components behind
+	REQUIRE_THROWS_AS(Component<OtherComponent>::CreateMany(ids.data() + 5, 6, 4.0), std::range_error);
+	REQUIRE(Component<OtherComponent>::Count() == 5);
+	REQUIRE(Component<OtherComponent>::FindOne(ids[5]) == nullptr);
+
+	for (Size i = 0; i < 5; i++)
+	{
+		Entity::Delete(ids[i]);
+	}
+
+	REQUIRE(Component<OtherComponent>::Count() == 0);
+	REQUIRE(Component<OtherComponent>::ChunkCount() == 0);
+}
+
+TEST_CASE("ForEach accepts both std::function and other function objects")
+{
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+
+	EntityID eId = Entity::Create();
+
+	for (int i = 0; i < 100; i++)
+	{
+		Component<SampleComponent>::Create(eId)->i = 1;
+	}
+
+	std::function<void(Component<SampleComponent>*)> increment = [](Component<SampleComponent>* c) { c->i++; };
+	Component<SampleComponent>::ForEach(increment);
+
+	int total = 0;
+	std::function<void(const Component<SampleComponent>*)> sum = [&total](const Component<SampleComponent>* c) { total += c->i; };
+	Component<SampleComponent>::CForEach(sum);
+
+	REQUIRE(total == 200);
+
+	struct Doubler
+	{
+		void operator()(Component<SampleComponent>* c) const { c->i *= 2; }
+	};
+
+	Component<SampleComponent>::ForEach(Doubler {});
+
+	total = 0;
+	Component<SampleComponent>::CForEach([&total](const Component<SampleComponent>* c) { total += c->i; });
+
+	REQUIRE(total == 400);
+
+	Entity::Delete(eId);
+
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+}
+
+TEST_CASE("ForEachChunk visits every storage block")
+{
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+
+	EntityID eId = Entity::Create();
+	std::vector<Component<SampleComponent>*> components;
+
+	for (int i = 0; i < 150; i++)
+	{
+		components.push_back(Component<SampleComponent>::Create(eId));
+		components.back()->i = 0;
+	}
+
+	components[3]->Delete();
+	components[70]->Delete();
+
+	Size chunks = 0;
+	Size occupied = 0;
+	Size full = 0;
+
+	Component<SampleComponent>::ForEachChunk([&](ChunkSpan<Component<SampleComponent>> span)
+	{
+		chunks++;
+		if (span.Full()) full++;
+
+		for (Size i = 0; i < span.size; i++)
+		{
+			if (span.IsOccupied(i))
+			{
+				span.data[i].i = 3;
+				occupied++;
+			}
+		}
+	});
+
+	REQUIRE(chunks == 3);
+	REQUIRE(full == 0);
+	REQUIRE(occupied == 148);
+
+	int total = 0;
+
+	Component<SampleComponent>::CForEachChunk([&total](ChunkSpan<const Component<SampleComponent>> span)
+	{
+		for (Size i = 0; i < span.size; i++)
+		{
+			if (span.IsOccupied(i)) total += span.data[i].i;
+		}
+	});
+
+	REQUIRE(total == 148 * 3);
+
+	Entity::Delete(eId);
+
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+}
+
+TEST_CASE("ParallelForEach visits every component")
+{
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+
+	EntityID eId = Entity::Create();
+
+	for (int i = 0; i < 1000; i++)
+	{
+		Component<SampleComponent>::Create(eId)->i = i;
+	}
+
+	Component<SampleComponent>::ParallelForEach([](Component<SampleComponent>* c)
+	{
+		c->i *= 2;
+	}, 2);
+
+	std::atomic<Long> total(0);
+
+	Component<SampleComponent>::CParallelForEach([&total](const Component<SampleComponent>* c)
+	{
+		total += c->i;
+	});
+
+	REQUIRE(total == 999 * 1000);
+
+	Entity::Delete(eId);
+
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+}
+
+struct SplitData
+{
+	SplitData(Float _x, Float _y) : x(_x), y(_y), unstored(0) { }
+
+	Float x;
+	Float y;
+	Int unstored;
+};
+
+namespace vlk
+{
+	template <>
+	struct ComponentFields<SplitData>
+	{
+		typedef FieldList<VLK_FIELD(SplitData, x), VLK_FIELD(SplitData, y)> Type;
+	};
+}
+
+template <>
+VLK_CXX14_CONSTEXPR inline ComponentHints vlk::GetComponentHints<SplitData>()
+{
+	return ComponentHints { 16, true, 1, 0, ComponentLayout::StructOfArrays };
+}
+
+TEST_CASE("Struct of arrays layout stores fields in columns")
+{
+	REQUIRE(!std::is_base_of<SplitData, Component<SplitData>>::value);
+
+	EntityID eId = Entity::Create();
+	std::vector<Component<SplitData>*> components;
+
+	for (int i = 0; i < 40; i++)
+	{
+		components.push_back(Component<SplitData>::Create(eId, static_cast<Float>(i), static_cast<Float>(2 * i)));
+	}
+
+	REQUIRE(Component<SplitData>::Count() == 40);
+	REQUIRE(Component<SplitData>::ChunkCount() == 3);
+
+	for (int i = 0; i < 40; i++)
+	{
+		REQUIRE(components[i]->Get(&SplitData::x) == static_cast<Float>(i));
+		REQUIRE(components[i]->Get(&SplitData::y) == static_cast<Float>(2 * i));
+		REQUIRE(components[i]->GetEntity() == eId);
+	}
+
+	REQUIRE_THROWS_AS(components[0]->Get(&SplitData::unstored), std::out_of_range);
+
+	Component<SplitData>::ForEach([](Component<SplitData>* c)
+	{
+		c->Get(&SplitData::y) += 1.0f;
+	});
+
+	Component<SplitData>::ForEachChunk([](ChunkSpan<Component<SplitData>> span)
+	{
+		Float* x = Component<SplitData>::FieldData(span, &SplitData::x);
+		const Float* y = Component<SplitData>::FieldData(span, &SplitData::y);
+
+		REQUIRE(reinterpret_cast<std::uintptr_t>(x) % 64 == 0);
+
+		for (Size i = 0; i < span.size; i++)
+		{
+			x[i] += y[i];
+		}
+	});
+
+	for (int i = 0; i < 40; i++)
+	{
+		REQUIRE(components[i]->Get(&SplitData::x) == static_cast<Float>(3 * i + 1));
+	}
+
+	Float total = 0.0f;
+
+	Component<SplitData>::CForEachChunk([&total](ChunkSpan<const Component<SplitData>> span)
+	{
+		const Float* y = Component<SplitData>::FieldData(span, &SplitData::y);
+
+		for (Size i = 0; i < span.size; i++)
+		{
+			if (span.IsOccupied(i)) total += y[i];
+		}
+	});
+
+	REQUIRE(total == static_cast<Float>(40 + 39 * 40));
+
+	Entity::Delete(eId);
+
+	REQUIRE(Component<SplitData>::Count() == 0);
+	REQUIRE(Component<SplitData>::ChunkCount() == 0);
+}
+
+struct CompactData
+{
+	Float x = 0.0f;
+	Float y = 0.0f;
+	Float z = 0.0f;
+};
+
+template <>
+VLK_CXX14_CONSTEXPR inline ComponentHints vlk::GetComponentHints<CompactData>()
+{
+	return ComponentHints { 16, true, 1, 0, ComponentLayout::ArrayOfStructs, true };
+}
+
+TEST_CASE("Compact storage stores entities outside of components")
+{
+	REQUIRE(sizeof(Component<CompactData>) == sizeof(CompactData));
+	REQUIRE(!std::is_base_of<IComponent, Component<CompactData>>::value);
+
+	EntityID e1 = Entity::Create();
+	EntityID e2 = Entity::Create();
+
+	std::vector<Component<CompactData>*> components;
+
+	for (int i = 0; i < 20; i++)
+	{
+		components.push_back(Component<CompactData>::Create(i % 2 == 0 ? e1 : e2));
+		components.back()->x = static_cast<Float>(i);
+	}
+
+	for (int i = 0; i < 20; i++)
+	{
+		REQUIRE(components[i]->GetEntity() == (i % 2 == 0 ? e1 : e2));
+		REQUIRE(components[i]->x == static_cast<Float>(i));
+	}
+
+	std::vector<Component<CompactData>*> found;
+	REQUIRE(Component<CompactData>::FindAll(e1, found) == 10);
+
+	components[1]->Attach(e1);
+	REQUIRE(components[1]->GetEntity() == e1);
+
+	components[3]->Delete();
+	REQUIRE(Component<CompactData>::Count() == 19);
+
+	Entity::Delete(e2);
+	REQUIRE(Component<CompactData>::Count() == 11);
+	REQUIRE(Component<CompactData>::FindOne(e2) == nullptr);
+
+	Entity::Delete(e1);
+	REQUIRE(Component<CompactData>::Count() == 0);
+	REQUIRE(Component<CompactData>::ChunkCount() == 0);
+
+	std::vector<EntityID> ids(40, e2);
+	Component<CompactData>::CreateMany(ids.data(), ids.size());
+	REQUIRE(Component<CompactData>::Count() == 40);
+
+	Entity::Delete(e2);
+	REQUIRE(Component<CompactData>::Count() == 0);
+}
+
+struct SizedData
+{
+	Double values[4];
+};
+
+template <>
+VLK_CXX14_CONSTEXPR inline ComponentHints vlk::GetComponentHints<SizedData>()
+{
+	return ComponentHints { 0, true, 1, 0, ComponentLayout::ArrayOfStructs, false, 4096 };
+}
+
+TEST_CASE("Block size can be given in bytes")
+{
+	typedef Component<SizedData>::ChunkType ChunkType;
+
+	REQUIRE(sizeof(ChunkType) <= 4096);
+	REQUIRE(sizeof(ChunkType) + sizeof(Component<SizedData>) > 4096);
+	REQUIRE(ChunkType::Alignment() == 4096);
+
+	EntityID eId = Entity::Create();
+	Component<SizedData>* c = Component<SizedData>::Create(eId);
+
+	REQUIRE(reinterpret_cast<std::uintptr_t>(c) % 64 == 0);
+	REQUIRE(Component<SizedData>::ChunkSize > 64);
+
+	Entity::Delete(eId);
+	REQUIRE(Component<SizedData>::Count() == 0);
+}
+
+struct RegionData
+{
+	Int i = 0;
+};
+
+template <>
+VLK_CXX14_CONSTEXPR inline ComponentHints vlk::GetComponentHints<RegionData>()
+{
+	return ComponentHints { 16, true, 0, 0, ComponentLayout::ArrayOfStructs, false, 0, 64 * 1024 * 1024 };
+}
+
+TEST_CASE("Components can be stored in a reserved region")
+{
+	typedef Component<RegionData>::AllocatorType RegionType;
+
+	EntityID eId = Entity::Create();
+	std::vector<Component<RegionData>*> components;
+
+	for (Size i = 0; i < Component<RegionData>::ChunkSize * 4; i++)
+	{
+		components.push_back(Component<RegionData>::Create(eId));
+	}
+
+	for (Component<RegionData>* c : components)
+	{
+		REQUIRE(RegionType::Contains(c));
+	}
+
+	REQUIRE(Component<RegionData>::ChunkCount() == 4);
+
+	Entity::Delete(eId);
+	REQUIRE(Component<RegionData>::Count() == 0);
+	Component<RegionData>::ShrinkToFit();
+}
+
+TEST_CASE("Component handles detect deleted components")
+{
+	EntityID eId = Entity::Create();
+
+	Component<SampleComponent>* a = Component<SampleComponent>::Create(eId);
+	Component<SampleComponent>* b = Component<SampleComponent>::Create(eId);
+
+	ComponentHandle<SampleComponent> ha = a->GetHandle();
+	ComponentHandle<SampleComponent> hb = b->GetHandle();
+
+	REQUIRE(ComponentHandle<SampleComponent>().IsNull());
+	REQUIRE(Component<SampleComponent>::Resolve(ComponentHandle<SampleComponent>()) == nullptr);
+	REQUIRE(!ha.IsNull());
+	REQUIRE(ha != hb);
+	REQUIRE(a->GetHandle() == ha);
+	REQUIRE(Component<SampleComponent>::Resolve(ha) == a);
+	REQUIRE(Component<SampleComponent>::Resolve(hb) == b);
+
+	a->Delete();
+	REQUIRE(Component<SampleComponent>::Resolve(ha) == nullptr);
+	REQUIRE(Component<SampleComponent>::Resolve(hb) == b);
+
+	// The new component may reuse both the memory and the handle slot of the old one
+	Component<SampleComponent>* c = Component<SampleComponent>::Create(eId);
+	ComponentHandle<SampleComponent> hc = c->GetHandle();
+
+	REQUIRE(hc != ha);
+	REQUIRE(Component<SampleComponent>::Resolve(ha) == nullptr);
+	REQUIRE(Component<SampleComponent>::Resolve(hc) == c);
+
+	Entity::Delete(eId);
+	REQUIRE(Component<SampleComponent>::Resolve(hb) == nullptr);
+	REQUIRE(Component<SampleComponent>::Resolve(hc) == nullptr);
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+}
+
+struct MovableData
+{
+	MovableData(Int _i) : i(_i) { }
+	MovableData(MovableData&&) = default;
+
+	Int i;
+};
+
+template <>
+VLK_CXX14_CONSTEXPR inline ComponentHints vlk::GetComponentHints<MovableData>()
+{
+	return ComponentHints { 16, true, 0 };
+}
+
+TEST_CASE("Defragmenting moves components into as few chunks as possible")
+{
+	EntityID eId = Entity::Create();
+	std::vector<Component<MovableData>*> components;
+
+	for (Int i = 0; i < 64; i++)
+	{
+		components.push_back(Component<MovableData>::Create(eId, i));
+	}
+
+	// Leave every chunk a quarter full
+	std::vector<ComponentHandle<MovableData>> handles;
+
+	for (Int i = 0; i < 64; i++)
+	{
+		if (i % 4 == 0) handles.push_back(components[i]->GetHandle());
+		else components[i]->Delete();
+	}
+
+	REQUIRE(Component<MovableData>::ChunkCount() == 4);
+
+	REQUIRE(Component<MovableData>::Defragment(1) == 1);
+
+	while (Component<MovableData>::Defragment(2) == 2);
+
+	REQUIRE(Component<MovableData>::Count() == 16);
+	REQUIRE(Component<MovableData>::ChunkCount() == 1);
+	REQUIRE(Component<MovableData>::Defragment(16) == 0);
+
+	// Handles and registry entries follow the moved components
+	for (Size i = 0; i < handles.size(); i++)
+	{
+		Component<MovableData>* c = Component<MovableData>::Resolve(handles[i]);
+		REQUIRE(c != nullptr);
+		REQUIRE(c->i == static_cast<Int>(i * 4));
+		REQUIRE(c->GetEntity() == eId);
+	}
+
+	std::vector<Component<MovableData>*> found;
+	REQUIRE(Component<MovableData>::FindAll(eId, found) == 16);
+
+	for (Component<MovableData>* c : found)
+	{
+		REQUIRE(c->i % 4 == 0);
+	}
+
+	Entity::Delete(eId);
+	REQUIRE(Component<MovableData>::Count() == 0);
+	REQUIRE(Component<MovableData>::ChunkCount() == 0);
+}
+
+TEST_CASE("Defragmenting moves split fields")
+{
+	EntityID eId = Entity::Create();
+	std::vector<Component<SplitData>*> components;
+
+	for (int i = 0; i < 32; i++)
+	{
+		components.push_back(Component<SplitData>::Create(eId, static_cast<Float>(i), static_cast<Float>(2 * i)));
+	}
+
+	std::vector<ComponentHandle<SplitData>> handles;
+
+	for (int i = 0; i < 32; i++)
+	{
+		if (i % 2 == 0) handles.push_back(components[i]->GetHandle());
+		else components[i]->Delete();
+	}
+
+	REQUIRE(Component<SplitData>::ChunkCount() == 2);
+	REQUIRE(Component<SplitData>::Defragment(64) == 8);
+	REQUIRE(Component<SplitData>::ChunkCount() == 1);
+
+	for (Size i = 0; i < handles.size(); i++)
+	{
+		Component<SplitData>* c = Component<SplitData>::Resolve(handles[i]);
+		REQUIRE(c->Get(&SplitData::x) == static_cast<Float>(2 * i));
+		REQUIRE(c->Get(&SplitData::y) == static_cast<Float>(4 * i));
+	}
+
+	Entity::Delete(eId);
+	REQUIRE(Component<SplitData>::Count() == 0);
+}
+
+TEST_CASE("Views visit entities with every component type")
+{
+	std::vector<EntityID> entities;
+
+	for (int i = 0; i < 100; i++)
+	{
+		EntityID eId = Entity::Create();
+		entities.push_back(eId);
+
+		Component<SampleComponent>::Create(eId)->i = i;
+		if (i % 2 == 0) Component<SimpleData>::Create(eId)->i = i;
+		if (i % 5 == 0) Component<MovableData>::Create(eId, i);
+	}
+
+	int visited = 0;
+
+	View<SampleComponent, SimpleData>::ForEach([&visited](Component<SampleComponent>* a, Component<SimpleData>* b)
+	{
+		REQUIRE(a->GetEntity() == b->GetEntity());
+		REQUIRE(a->i == b->i);
+		b->d = 1.0;
+		visited++;
+	});
+
+	REQUIRE(visited == 50);
+
+	// Driven by the smallest pool regardless of the order of the types
+	visited = 0;
+
+	View<SimpleData, SampleComponent, MovableData>::CForEach([&visited](const Component<SimpleData>* a, const Component<SampleComponent>* b, const Component<MovableData>* c)
+	{
+		REQUIRE(a->i == b->i);
+		REQUIRE(c->i == b->i);
+		REQUIRE(a->d == 1.0);
+		visited++;
+	});
+
+	REQUIRE(visited == 10);
+
+	std::vector<View<MovableData, SampleComponent>::TupleType> found;
+	REQUIRE(View<MovableData, SampleComponent>::Collect(found) == 20);
+	REQUIRE(std::get<0>(found[0])->GetEntity() == std::get<1>(found[0])->GetEntity());
+
+	for (EntityID eId : entities)
+	{
+		Entity::Delete(eId);
+	}
+
+	REQUIRE(Component<SampleComponent>::Count() == 0);
+	REQUIRE(Component<SimpleData>::Count() == 0);
+	REQUIRE(Component<MovableData>::Count() == 0);
+}
+
+struct ArchPosition
+{
+	ArchPosition(Float _x) : x(_x) { }
+
+	Float x;
+};
+
+struct ArchVelocity
+{
+	ArchVelocity(Float _x) : x(_x) { }
+
+	Float x;
+};
+
+struct ArchName
+{
+	ArchName(const std::string& _name) : name(_name) { }
+
+	std::string name;
+};
+
+TEST_CASE("Archetype storage migrates entities between archetypes")
+{
+	std::vector<EntityID> entities;
+
+	for (int i = 0; i < 2000; i++)
+	{
+		EntityID eId = Entity::Create();
+		entities.push_back(eId);
+
+		ArchetypeStorage::Attach<ArchPosition>(eId, static_cast<Float>(i));
+		if (i % 2 == 0) ArchetypeStorage::Attach<ArchVelocity>(eId, 1.0f);
+		if (i % 4 == 0) ArchetypeStorage::Attach<ArchName>(eId, std::to_string(i));
+	}
+
+	REQUIRE(ArchetypeStorage::EntityCount() == 2000);
+	REQUIRE_THROWS_AS(ArchetypeStorage::Attach<ArchPosition>(entities[0], 0.0f), std::logic_error);
+
+	int visited = 0;
+
+	ArchetypeQuery<ArchPosition, ArchVelocity>::ForEach([&visited](ArchPosition& p, ArchVelocity& v)
+	{
+		p.x += v.x;
+		visited++;
+	});
+
+	REQUIRE(visited == 1000);
+
+	std::vector<std::pair<EntityID, ArchName*>> rows;
+
+	ArchetypeQuery<ArchName, ArchPosition>::ForEachChunk([&rows](Size n, const EntityID* ids, ArchName* names, ArchPosition* p)
+	{
+		REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+
+		for (Size i = 0; i < n; i++)
+		{
+			REQUIRE(names[i].name == std::to_string(static_cast<int>(p[i].x) - 1));
+			rows.emplace_back(ids[i], &names[i]);
+		}
+	});
+
+	REQUIRE(rows.size() == 500);
+
+	for (auto& row : rows)
+	{
+		REQUIRE(ArchetypeStorage::Get<ArchName>(row.first) == row.second);
+	}
+
+	// Removing types moves entities, the data of the others must follow them
+	for (int i = 0; i < 2000; i += 4)
+	{
+		REQUIRE(ArchetypeStorage::Detach<ArchVelocity>(entities[i]));
+		REQUIRE(!ArchetypeStorage::Detach<ArchVelocity>(entities[i]));
+	}
+
+	for (int i = 0; i < 2000; i++)
+	{
+		ArchPosition* p = ArchetypeStorage::Get<ArchPosition>(entities[i]);
+		REQUIRE(p != nullptr);
+		REQUIRE(p->x == static_cast<Float>(i + (i % 2 == 0)));
+		REQUIRE((ArchetypeStorage::Get<ArchVelocity>(entities[i]) != nullptr) == (i % 4 == 2));
+		REQUIRE((ArchetypeStorage::Get<ArchName>(entities[i]) != nullptr) == (i % 4 == 0));
+	}
+
+	Float total = 0.0f;
+
+	ArchetypeQuery<ArchPosition>::CForEach([&total](const ArchPosition& p)
+	{
+		total += p.x;
+	});
+
+	REQUIRE(total == static_cast<Float>(1999 * 2000 / 2 + 1000));
+
+	for (int i = 0; i < 2000; i += 2)
+	{
+		ArchetypeStorage::Detach<ArchPosition>(entities[i]);
+	}
+
+	REQUIRE(ArchetypeStorage::EntityCount() == 2000);
+
+	for (EntityID eId : entities)
+	{
+		Entity::Delete(eId);
+	}
+
+	REQUIRE(ArchetypeStorage::EntityCount() == 0);
+	REQUIRE(ArchetypeStorage::Get<ArchPosition>(entities[1]) == nullptr);
+}
+
+TEST_CASE("Entity index tracks components across pages")
+{
+	int values[8];
+
+	// IDs spread over several pages, including the first and last slot of a page
+	const EntityID ids[4] = { 1, 4095, 4096, 1 << 20 };
+
+	for (Size i = 0; i < 4; i++)
+	{
+		EntityIndex<int>::AddEntry(ids[i], &values[i]);
+	}
+
+	REQUIRE(EntityIndex<int>::EntityCount() == 4);
+
+	for (Size i = 0; i < 4; i++)
+	{
+		REQUIRE(EntityIndex<int>::LookupOne(ids[i]) == &values[i]);
+	}
+
+	REQUIRE(EntityIndex<int>::LookupOne(2) == nullptr);
+	REQUIRE(EntityIndex<int>::LookupOne(1 << 21) == nullptr);
+
+	// Further associations with the same entity
+	EntityIndex<int>::AddEntry(4096, &values[4]);
+	EntityIndex<int>::AddEntry(4096, &values[5]);
+
+	std::vector<int*> found;
+	REQUIRE(EntityIndex<int>::LookupAll(4096, found) == 3);
+	REQUIRE(std::count(found.begin(), found.end(), &values[2]) == 1);
+	REQUIRE(std::count(found.begin(), found.end(), &values[5]) == 1);
+
+	EntityIndex<int>::RemoveOne(4096, &values[2]);
+	REQUIRE(EntityIndex<int>::LookupOne(4096) != nullptr);
+	REQUIRE(EntityIndex<int>::LookupOne(4096) != &values[2]);
+
+	int* from[1] = { &values[4] };
+	int* to[1] = { &values[6] };
+	EntityIndex<int>::ReplaceEntries(&ids[2], from, to, 1);
+
+	found.clear();
+	REQUIRE(EntityIndex<int>::LookupAll(4096, found) == 2);
+	REQUIRE(std::count(found.begin(), found.end(), &values[6]) == 1);
+	REQUIRE(std::count(found.begin(), found.end(), &values[4]) == 0);
+
+	// Removing an entity moves the last dense entry into its place
+	EntityIndex<int>::RemoveOne(1, &values[0]);
+	REQUIRE(EntityIndex<int>::LookupOne(1) == nullptr);
+	REQUIRE(EntityIndex<int>::LookupOne(1 << 20) == &values[3]);
+	REQUIRE(EntityIndex<int>::LookupOne(4095) == &values[1]);
+
+	REQUIRE(EntityIndex<int>::RemoveAll(4096) == 2);
+	REQUIRE(EntityIndex<int>::RemoveAll(4096) == 0);
+	REQUIRE(EntityIndex<int>::LookupOne(4096) == nullptr);
+
+	EntityIndex<int>::RemoveOne(4095, &values[1]);
+	EntityIndex<int>::RemoveOne(1 << 20, &values[3]);
+	REQUIRE(EntityIndex<int>::EntityCount() == 0);
+}
+
+TEST_CASE("Registry keeps associations consistent as it grows and shrinks")
+{
+	std::vector<double> values(4000);
+
+	// Entity i gets (i % 4) + 1 associations, enough to spill past the inline storage
+	for (Size i = 0; i < 1000; i++)
+	{
+		for (Size j = 0; j <= i % 4; j++)
+		{
+			ECRegistry<double>::AddEntry(i, &values[i + j * 1000]);
+		}
+	}
+
+	std::vector<double*> found;
+
+	for (Size i = 0; i < 1000; i++)
+	{
+		found.clear();
+		REQUIRE(ECRegistry<double>::LookupAll(i, found) == (i % 4) + 1);
+		REQUIRE(ECRegistry<double>::LookupOne(i) != nullptr);
+	}
+
+	// Remove every other entity, so later slots in each probe sequence have to shift back
+	for (Size i = 0; i < 1000; i += 2)
+	{
+		ECRegistry<double>::RemoveOne(i, &values[i]);
+		ECRegistry<double>::RemoveAll(i);
+	}
+
+	for (Size i = 0; i < 1000; i++)
+	{
+		found.clear();
+		Size expected = (i % 2 == 0) ? 0 : (i % 4) + 1;
+		REQUIRE(ECRegistry<double>::LookupAll(i, found) == expected);
+		REQUIRE((ECRegistry<double>::LookupOne(i) == nullptr) == (expected == 0));
+	}
+
+	// Removing the first association moves the last one into its place
+	ECRegistry<double>::RemoveOne(3, &values[3]);
+	found.clear();
+	REQUIRE(ECRegistry<double>::LookupAll(3, found) == 3);
+	REQUIRE(std::count(found.begin(), found.end(), &values[3]) == 0);
+
+	for (Size i = 1; i < 1000; i += 2)
+	{
+		REQUIRE(ECRegistry<double>::RemoveAll(i) == ((i == 3) ? 3 : (i % 4) + 1));
+	}
+
+	REQUIRE(ECRegistry<double>::LookupOne(1) == nullptr);
+}
+
+TEST_CASE("Registry shards allow concurrent attachment")
+{
+	const Size perThread = 2000;
+	std::vector<char> values(4 * perThread);
+	std::vector<std::thread> threads;
+
+	for (Size t = 0; t < 4; t++)
+	{
+		threads.emplace_back([t, perThread, &values]()
+		{
+			// Each thread works on its own range of entities, which span every shard
+			for (Size i = t * perThread; i < (t + 1) * perThread; i++)
+			{
+				ECRegistry<char>::AddEntry(i, &values[i]);
+			}
+
+			for (Size i = t * perThread; i < (t + 1) * perThread; i += 2)
+			{
+				ECRegistry<char>::RemoveOne(i, &values[i]);
+			}
+		});
+	}
+
+	for (std::thread& th : threads)
+	{
+		th.join();
+	}
+
+	for (Size i = 0; i < 4 * perThread; i++)
+	{
+		REQUIRE(ECRegistry<char>::LookupOne(i) == ((i % 2 == 0) ? nullptr : &values[i]));
+	}
+}
+
+TEST_CASE("Entity signatures track attached component types")
+{
+	REQUIRE(Component<SampleComponent>::TypeID() != Component<SimpleData>::TypeID());
+	REQUIRE(Component<SampleComponent>::TypeID() == Component<SampleComponent>::TypeID());
+
+	EntityID e1 = Entity::Create();
+	EntityID e2 = Entity::Create();
+
+	Component<SampleComponent>* a = Component<SampleComponent>::Create(e1);
+	Component<SampleComponent>* b = Component<SampleComponent>::Create(e1);
+	Component<CompactData>::Create(e1);
+	Component<SimpleData>::Create(e2);
+
+	REQUIRE(Component<SampleComponent>::Has(e1));
+	REQUIRE(Component<CompactData>::Has(e1));
+	REQUIRE_FALSE(Component<SimpleData>::Has(e1));
+	REQUIRE_FALSE(Component<SampleComponent>::Has(e2));
+
+	REQUIRE(View<SampleComponent, CompactData>::Matches(e1));
+	REQUIRE_FALSE(View<SampleComponent, SimpleData>::Matches(e1));
+
+	ComponentSignature signature = EntitySignatures::Get(e1);
+	REQUIRE(signature.Contains(View<SampleComponent, CompactData>::Signature()));
+	REQUIRE(signature.Test(Component<CompactData>::TypeID()));
+
+	// The bit stays set until the last component of the type is detached
+	a->Attach(e2);
+	REQUIRE(Component<SampleComponent>::Has(e1));
+	REQUIRE(Component<SampleComponent>::Has(e2));
+
+	b->Delete();
+	REQUIRE_FALSE(Component<SampleComponent>::Has(e1));
+	REQUIRE(View<SampleComponent, SimpleData>::Matches(e2));
+
+	Entity::Delete(e1);
+	Entity::Delete(e2);
+
+	REQUIRE(EntitySignatures::Get(e1).Empty());
+	REQUIRE(EntitySignatures::Get(e2).Empty());
+	REQUIRE(Component<CompactData>::FindOne(e1) == nullptr);
+	REQUIRE(Component<SampleComponent>::FindOne(e2) == nullptr);
+	REQUIRE(Component<SimpleData>::FindOne(e2) == nullptr);
+}
+
+TEST_CASE("Components attached to the same entity can be removed in any order")
+{
+	EntityID e1 = Entity::Create();
+	EntityID e2 = Entity::Create();
+
+	std::vector<Component<SimpleData>*> comps;
+
+	for (int i = 0; i < 20; i++)
+	{
+		comps.push_back(Component<SimpleData>::Create(e1));
+		comps.back()->i = i;
+	}
+
+	// Delete from the middle, the front and the back of the entity's list
+	comps[10]->Delete();
+	comps[0]->Delete();
+	comps[19]->Delete();
+
+	std::vector<Component<SimpleData>*> found;
+	REQUIRE(Component<SimpleData>::FindAll(e1, found) == 17);
+
+	// Moving components to another entity re-keys them
+	for (int i = 1; i < 19; i += 2)
+	{
+		if (i != 10) comps[i]->Attach(e2);
+	}
+
+	found.clear();
+	REQUIRE(Component<SimpleData>::FindAll(e1, found) == 8);
+
+	for (Component<SimpleData>* c : found)
+	{
+		REQUIRE(c->GetEntity() == e1);
+		REQUIRE(c->i % 2 == 0);
+	}
+
+	found.clear();
+	REQUIRE(Component<SimpleData>::FindAll(e2, found) == 9);
+
+	for (Component<SimpleData>* c : found)
+	{
+		REQUIRE(c->GetEntity() == e2);
+		REQUIRE(c->i % 2 == 1);
+	}
+
+	// A lone component is re-keyed in place
+	EntityID e3 = Entity::Create();
+	Component<SimpleData>* lone = Component<SimpleData>::Create(e3);
+	EntityID e4 = Entity::Create();
+	lone->Attach(e4);
+
+	REQUIRE(Component<SimpleData>::FindOne(e3) == nullptr);
+	REQUIRE(Component<SimpleData>::FindOne(e4) == lone);
+	REQUIRE_FALSE(Component<SimpleData>::Has(e3));
+	REQUIRE(Component<SimpleData>::Has(e4));
+
+	Entity::Delete(e1);
+	Entity::Delete(e2);
+	Entity::Delete(e4);
+
+	REQUIRE(Component<SimpleData>::Count() == 0);
+}
+
+TEST_CASE("FindOne can be called while components are being created and deleted")
+{
+	// Entities that are never modified, spread over several index pages
+	std::vector<EntityID> stable;
+	std::vector<Component<SimpleData>*> expected;
+
+	for (int i = 0; i < 64; i++)
+	{
+		for (int j = 0; j < 500; j++)
+		{
+			(void)Entity::Create();
+		}
+
+		stable.push_back(Entity::Create());
+		expected.push_back(Component<SimpleData>::Create(stable.back()));
+	}
+
+	std::atomic<bool> done(false);
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> readers;
+
+	for (int t = 0; t < 4; t++)
+	{
+		readers.emplace_back([&]()
+		{
+			while (!done.load())
+			{
+				for (Size i = 0; i < stable.size(); i++)
+				{
+					if (Component<SimpleData>::FindOne(stable[i]) != expected[i]) mismatches++;
+				}
+			}
+		});
+	}
+
+	// Churn entities with new IDs, so the index keeps allocating and freeing pages
+	for (int round = 0; round < 20; round++)
+	{
+		std::vector<EntityID> ids;
+
+		for (int i = 0; i < 2000; i++)
+		{
+			ids.push_back(Entity::Create());
+		}
+
+		Component<SimpleData>::CreateMany(ids.data(), ids.size());
+
+		for (EntityID eId : ids)
+		{
+			REQUIRE(Component<SimpleData>::FindOne(eId) != nullptr);
+			Entity::Delete(eId);
+		}
+	}
+
+	done.store(true);
+
+	for (std::thread& th : readers)
+	{
+		th.join();
+	}
+
+	REQUIRE(mismatches.load() == 0);
+
+	for (EntityID eId : stable)
+	{
+		Entity::Delete(eId);
+		REQUIRE(Component<SimpleData>::FindOne(eId) == nullptr);
+	}
+
+	Epoch::Reclaim();
+}
+
+TEST_CASE("FindMany finds a component for each entity in order")
+{
+	std::vector<EntityID> ids;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		EntityID eId = Entity::Create();
+		ids.push_back(eId);
+
+		if (i % 3 != 0) Component<SimpleData>::Create(eId)->i = i;
+	}
+
+	// Repeated and unknown entities
+	ids.push_back(ids[1]);
+	ids.push_back(ids.back() + (1 << 20));
+
+	std::vector<Component<SimpleData>*> out(ids.size());
+	REQUIRE(Component<SimpleData>::FindMany(ids.data(), ids.size(), out.data()) == 666 + 1);
+
+	for (Size i = 0; i < ids.size(); i++)
+	{
+		REQUIRE(out[i] == Component<SimpleData>::FindOne(ids[i]));
+	}
+
+	REQUIRE(out[1000] == out[1]);
+	REQUIRE(out[1001] == nullptr);
+
+	for (Size i = 0; i < 1000; i++)
+	{
+		Entity::Delete(ids[i]);
+	}
+
+	REQUIRE(Component<SimpleData>::FindMany(ids.data(), 1000, out.data()) == 0);
+}
+
+template <Size N>
+struct TypeLimitTag { int value; };
+
+struct TypeLimitExtra { int value; };
+
+template <Size I>
+void RegisterTypeLimitTag()
+{
+	// Types used by other tests may already hold some of the IDs
+	try { (void)Component<TypeLimitTag<I>>::TypeID(); }
+	catch (const std::length_error&) { }
+}
+
+template <Size... I>
+void RegisterTypeLimitTags(std::index_sequence<I...>)
+{
+	int expand[] = {0, (RegisterTypeLimitTag<I>(), 0)...};
+	(void)expand;
+}
+
+// Uses up every type ID for the rest of the process, so it is hidden and run on its own
+TEST_CASE("Running out of type IDs does not leave components behind", "[.][typelimit]")
+{
+	RegisterTypeLimitTags(std::make_index_sequence<ComponentSignature::Capacity>());
+
+	EntityID eId = Entity::Create();
+	std::vector<EntityID> ids(10, eId);
+
+	REQUIRE_THROWS_AS(Component<TypeLimitExtra>::Create(eId), std::length_error);
+	REQUIRE_THROWS_AS(Component<TypeLimitExtra>::CreateMany(ids.data(), ids.size()), std::length_error);
+
+	REQUIRE(Component<TypeLimitExtra>::Count() == 0);
+	REQUIRE(Component<TypeLimitExtra>::FindOne(eId) == nullptr);
+}
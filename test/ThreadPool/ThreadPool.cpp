@@ -0,0 +1,100 @@
+#include "ValkyrieEngine/ThreadPool.hpp"
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace vlk;
+
+TEST_CASE("ThreadPool visits every index exactly once")
+{
+	ThreadPool pool(3);
+	REQUIRE(pool.WorkerCount() == 3);
+
+	std::vector<std::atomic<Int>> visits(1000);
+	for (auto& v : visits) v = 0;
+
+	pool.ParallelFor(visits.size(), [&visits](Size i) { visits[i]++; });
+
+	for (auto& v : visits)
+	{
+		REQUIRE(v == 1);
+	}
+}
+
+TEST_CASE("ThreadPool without workers runs on the calling thread")
+{
+	ThreadPool pool(0);
+	std::thread::id caller = std::this_thread::get_id();
+	bool sameThread = true;
+
+	pool.ParallelFor(100, [&](Size) { sameThread &= (std::this_thread::get_id() == caller); });
+
+	REQUIRE(sameThread);
+}
+
+TEST_CASE("ThreadPool supports nested loops")
+{
+	ThreadPool pool(2);
+	std::atomic<Int> total(0);
+
+	pool.ParallelFor(8, [&](Size)
+	{
+		pool.ParallelFor(8, [&](Size) { total++; });
+	});
+
+	REQUIRE(total == 64);
+}
+
+TEST_CASE("ThreadPool callers never run work queued by other callers")
+{
+	ThreadPool pool(2);
+	std::mutex mtx;
+	std::vector<std::thread::id> ranA;
+	std::vector<std::thread::id> ranB;
+	std::thread::id callerA;
+	std::thread::id callerB;
+
+	// Record which threads run each caller's indices
+	auto loop = [&pool, &mtx](std::thread::id& caller, std::vector<std::thread::id>& ran)
+	{
+		caller = std::this_thread::get_id();
+
+		pool.ParallelFor(200, [&mtx, &ran](Size)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+			std::unique_lock<std::mutex> ulock(mtx);
+			ran.push_back(std::this_thread::get_id());
+		});
+	};
+
+	std::thread a(loop, std::ref(callerA), std::ref(ranA));
+	std::thread b(loop, std::ref(callerB), std::ref(ranB));
+	a.join();
+	b.join();
+
+	REQUIRE(ranA.size() == 200);
+	REQUIRE(ranB.size() == 200);
+	REQUIRE(std::count(ranA.begin(), ranA.end(), callerB) == 0);
+	REQUIRE(std::count(ranB.begin(), ranB.end(), callerA) == 0);
+}
+
+TEST_CASE("ThreadPool rethrows exceptions on the calling thread")
+{
+	ThreadPool pool(2);
+
+	REQUIRE_THROWS_AS(pool.ParallelFor(100, [](Size i)
+	{
+		if (i == 50) throw std::runtime_error("Failure");
+	}), std::runtime_error);
+
+	// Pool is still usable afterwards
+	std::atomic<Int> total(0);
+	pool.ParallelFor(10, [&total](Size) { total++; });
+	REQUIRE(total == 10);
+}